@@ -0,0 +1,345 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "custom_bot.h"
+#include "game_record.h"
+#include "search_pool.h"
+
+using namespace std;
+
+// batch position analysis: streams positions from a file and searches them on all cores
+// usage: analyze <file> [-threads N] [-depth D] [-nodes N] [-time ms] [-k K] [-stride S] [-cache file] [-net file] [-deterministic] [-pool]
+// text file: one position per line, the moves "row,col row,col ..." played by 1, -1, 1, ...
+//            empty lines and lines starting with # are skipped
+// record file (game_record.h, detected by its magic): every S-th position of every game
+// -cache: persistent position cache shared with other processes, cached positions report only their best move
+// -net: evaluate with the network of this weights file (nnue_train.cpp) instead of the pattern scores
+// -deterministic: node budgets instead of the clock (Gomoku::setDeterministic), results printed in input
+//                 order without timings, so runs with any number of threads give the same output
+// -pool: many searches at once on a SearchPool (search_pool.h) of N threads instead of one search
+//        per thread, for short searches of many positions. Results come in input order, without timings
+
+const int QUEUE_PER_THREAD = 4;
+const int POOL_SEARCHES_PER_THREAD = 16; // searches in flight per pool thread
+
+struct Position{
+    long long id;
+    long long sequence; // input order
+    int board[HEIGHT][WIDTH];
+    int color;  // side to move
+};
+
+// results are printed as they complete, or in input order when ordered
+struct Output{
+    mutex lock;
+    bool ordered;
+    long long next;     // sequence printed next
+    map<long long, string> pending;
+};
+
+// bounded queue between the reader and the search threads
+class PositionQueue{
+private:
+    deque<unique_ptr<Position>> items;
+    size_t capacity;
+    bool closed;
+    mutex lock;
+    condition_variable not_empty, not_full;
+
+public:
+    PositionQueue(size_t in_capacity){
+        capacity = in_capacity;
+        closed = false;
+    }
+
+    void push(unique_ptr<Position> position){
+        unique_lock<mutex> guard(lock);
+        not_full.wait(guard, [this]{ return items.size() < capacity; });
+        items.push_back(move(position));
+        not_empty.notify_one();
+    }
+
+    // return NULL once the queue is closed and drained
+    unique_ptr<Position> pop(){
+        unique_lock<mutex> guard(lock);
+        not_empty.wait(guard, [this]{ return !items.empty() || closed; });
+        if(items.empty()) return NULL;
+        unique_ptr<Position> position = move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return position;
+    }
+
+    void close(){
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        not_empty.notify_all();
+    }
+};
+
+long long read_text_positions(const char *path, PositionQueue &queue);
+long long read_record_positions(const char *path, int stride, PositionQueue &queue);
+bool is_record_file(const char *path);
+void analyze_worker(PositionQueue &queue, const SearchLimits &limits, int top_k, PositionCache *cache, const Network *network, bool deterministic, Output &output);
+void analyze_pooled(PositionQueue &queue, const SearchLimits &limits, int top_k, PositionCache *cache, const Network *network, bool deterministic, int num_threads, Output &output);
+void report(const Position &position, const SearchInfo &info, const vector<RootMove> &moves, int top_k, double ms, Output &output);
+
+int main(int argc, char **argv){
+    if(argc < 2){
+        cout<<"usage: analyze <file> [-threads N] [-depth D] [-nodes N] [-time ms] [-k K] [-stride S] [-cache file] [-net file] [-deterministic] [-pool]"<<endl;
+        return 1;
+    }
+    const char *path = argv[1];
+    int num_threads = (int)thread::hardware_concurrency();
+    int top_k = 3;
+    int stride = 1;
+    SearchLimits limits;
+    const char *cache_path = NULL;
+    const char *net_path = NULL;
+    bool deterministic = false;
+    bool pooled = false;
+    for(int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if(arg == "-deterministic"){
+            deterministic = true;
+            continue;
+        }
+        if(arg == "-pool"){
+            pooled = true;
+            continue;
+        }
+        if(i + 1 >= argc){
+            cout<<"missing value for "<<arg<<endl;
+            return 1;
+        }
+        if(arg == "-threads") num_threads = atoi(argv[++i]);
+        else if(arg == "-depth") limits.depth = atoi(argv[++i]);
+        else if(arg == "-nodes") limits.nodes = atoll(argv[++i]);
+        else if(arg == "-time") limits.time_ms = atoll(argv[++i]);
+        else if(arg == "-k") top_k = atoi(argv[++i]);
+        else if(arg == "-stride") stride = atoi(argv[++i]);
+        else if(arg == "-cache") cache_path = argv[++i];
+        else if(arg == "-net") net_path = argv[++i];
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+    if(num_threads < 1) num_threads = 1;
+    if(stride < 1) stride = 1;
+
+    // the shared cache holds scores of the pattern evaluation
+    if(cache_path && net_path){
+        cout<<"-cache and -net can't be combined"<<endl;
+        return 1;
+    }
+    static Network network;
+    if(net_path && !network.load(net_path)){
+        cout<<"can't load network "<<net_path<<endl;
+        return 1;
+    }
+
+    PositionCache cache;
+    if(cache_path && !cache.open(cache_path, Gomoku::rule_id)){
+        cout<<"can't open cache "<<cache_path<<" (or it belongs to another win rule)"<<endl;
+        return 1;
+    }
+
+    PositionQueue queue(num_threads * QUEUE_PER_THREAD);
+    Output output;
+    output.ordered = deterministic;
+    output.next = 0;
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    if(pooled){
+        workers.push_back(thread(analyze_pooled, ref(queue), cref(limits), top_k, cache_path ? &cache : NULL,
+                                 net_path ? &network : NULL, deterministic, num_threads, ref(output)));
+    }
+    for(int t = 0; t < num_threads && !pooled; t++){
+        workers.push_back(thread(analyze_worker, ref(queue), cref(limits), top_k, cache_path ? &cache : NULL,
+                                 net_path ? &network : NULL, deterministic, ref(output)));
+    }
+
+    long long count;
+    if(is_record_file(path)) count = read_record_positions(path, stride, queue);
+    else count = read_text_positions(path, queue);
+    queue.close();
+    for(auto &worker : workers) worker.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(count < 0){
+        cerr<<"can't read "<<path<<endl;
+        return 1;
+    }
+    cerr<<count<<" positions in "<<fixed<<setprecision(3)<<seconds<<" s, "
+        <<setprecision(1)<<(seconds > 0 ? count / seconds : 0)<<" positions/s"<<endl;
+    return 0;
+}
+
+// search threads: every thread owns its engine
+void analyze_worker(PositionQueue &queue, const SearchLimits &limits, int top_k, PositionCache *cache, const Network *network, bool deterministic, Output &output){
+    unique_ptr<Gomoku> engine(new Gomoku());
+    engine->setCache(cache);
+    engine->setNetwork(network);
+    engine->setDeterministic(deterministic);
+    vector<RootMove> moves;
+    unique_ptr<Position> position;
+    while((position = queue.pop()) != NULL){
+        auto start = chrono::steady_clock::now();
+        SearchInfo info = engine->search(position->board, position->color, limits, &moves);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        report(*position, info, moves, top_k, deterministic ? -1 : ms, output);
+    }
+}
+
+// pool mode: up to POOL_SEARCHES_PER_THREAD searches per thread at once, every one on its
+// own engine. Engines are reused round robin, a slot first waits for its previous search,
+// so the results are reported in input order
+void analyze_pooled(PositionQueue &queue, const SearchLimits &limits, int top_k, PositionCache *cache, const Network *network, bool deterministic, int num_threads, Output &output){
+    struct Slot{
+        unique_ptr<Gomoku> engine;
+        vector<RootMove> moves;
+        unique_ptr<Position> position;
+        shared_ptr<PooledSearch> search;
+    };
+    int in_flight = num_threads * POOL_SEARCHES_PER_THREAD;
+    vector<Slot> slots(in_flight);
+    auto finish = [&](Slot &slot){
+        if(!slot.position) return;
+        SearchInfo info = slot.search->wait();
+        report(*slot.position, info, slot.moves, top_k, -1, output);
+        slot.search.reset();
+        slot.position.reset();
+    };
+    SearchPool pool(num_threads);
+    unique_ptr<Position> position;
+    for(long long i = 0; (position = queue.pop()) != NULL; i++){
+        Slot &slot = slots[i % in_flight];
+        finish(slot);
+        if(!slot.engine){
+            slot.engine.reset(new Gomoku());
+            slot.engine->setCache(cache);
+            slot.engine->setNetwork(network);
+            slot.engine->setDeterministic(deterministic);
+        }
+        slot.position = move(position);
+        slot.search = pool.submit(*slot.engine, slot.position->board, slot.position->color, limits, &slot.moves);
+    }
+    for(int i = 0; i < in_flight; i++) finish(slots[i]);
+}
+
+// one result line, ms < 0 leaves out the time
+void report(const Position &position, const SearchInfo &info, const vector<RootMove> &moves, int top_k, double ms, Output &output){
+    ostringstream line;
+    line<<position.id<<" depth "<<info.depth<<" nodes "<<info.nodes;
+    if(ms >= 0) line<<" time "<<fixed<<setprecision(1)<<ms;
+    line<<" |"<<fixed<<setprecision(4);
+    for(int i = 0; i < (int)moves.size() && i < top_k; i++){
+        line<<" "<<moves[i].point.x<<","<<moves[i].point.y<<" "<<moves[i].score<<";";
+    }
+    lock_guard<mutex> guard(output.lock);
+    if(!output.ordered){
+        cout<<line.str()<<'\n';
+        return;
+    }
+    output.pending[position.sequence] = line.str();
+    while(!output.pending.empty() && output.pending.begin()->first == output.next){
+        cout<<output.pending.begin()->second<<'\n';
+        output.pending.erase(output.pending.begin());
+        output.next++;
+    }
+}
+
+bool is_record_file(const char *path){
+    ifstream in(path, ios::binary);
+    char magic[2];
+    return in.read(magic, 2) && magic[0] == (char)RECORD_MAGIC_0 && magic[1] == (char)RECORD_MAGIC_1;
+}
+
+// text positions, the id is the line number
+long long read_text_positions(const char *path, PositionQueue &queue){
+    ifstream in(path);
+    if(!in) return -1;
+    string line;
+    long long line_number = 0, count = 0;
+    while(getline(in, line)){
+        line_number++;
+        if(line.empty() || line[0] == '#') continue;
+        unique_ptr<Position> position(new Position());
+        position->id = line_number;
+        memset(position->board, 0, sizeof(position->board));
+        istringstream moves(line);
+        string token;
+        int color = 1;
+        bool ok = true;
+        while(moves>>token){
+            int row, col;
+            if(sscanf(token.c_str(), "%d,%d", &row, &col) != 2 || row < 0 || row >= HEIGHT
+               || col < 0 || col >= WIDTH || position->board[row][col] != 0){
+                ok = false;
+                break;
+            }
+            position->board[row][col] = color;
+            color = -color;
+        }
+        if(!ok){
+            cerr<<"line "<<line_number<<": bad move "<<token<<endl;
+            continue;
+        }
+        position->color = color;
+        position->sequence = count;
+        queue.push(move(position));
+        count++;
+    }
+    return count;
+}
+
+// record positions, the id is game * 10000 + ply
+long long read_record_positions(const char *path, int stride, PositionQueue &queue){
+    GameRecordReader reader;
+    if(!reader.open(path)) return -1;
+    GameView game;
+    long long game_number = 0, count = 0, skipped = 0;
+    static int board[HEIGHT][WIDTH];
+    vector<Point> moves;
+    while(reader.next(game)){
+        game_number++;
+        // a game of another rule, board or with a bad move is skipped whole
+        if(game.rule != Gomoku::rule_id || !readGameMoves(game, moves)){
+            skipped++;
+            continue;
+        }
+        memset(board, 0, sizeof(board));
+        int color = 1;
+        for(int ply = 0; ply < (int)moves.size(); ply++){
+            if(ply % stride == 0){
+                unique_ptr<Position> position(new Position());
+                position->id = game_number * 10000 + ply;
+                memcpy(position->board, board, sizeof(board));
+                position->color = color;
+                position->sequence = count;
+                queue.push(move(position));
+                count++;
+            }
+            board[moves[ply].x][moves[ply].y] = color;
+            color = -color;
+        }
+    }
+    if(skipped > 0) cerr<<"skipped "<<skipped<<" games of another rule or board, or with invalid moves"<<endl;
+    if(reader.corrupt()) cerr<<"corrupt record after game "<<game_number<<", the rest of "<<path<<" is ignored"<<endl;
+    return count;
+}
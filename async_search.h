@@ -0,0 +1,96 @@
+#ifndef ASYNC_SEARCH
+#define ASYNC_SEARCH
+
+#include <future>
+#include <vector>
+#include "config.h"
+#include "custom_bot.h"
+
+// Runs Gomoku::search on its own thread.
+// The engine must outlive the handle and must not be used elsewhere while the search runs.
+class SearchHandle
+{
+private:
+    Gomoku *engine;
+    std::vector<int> board; // private copy, the caller may keep changing its board
+    std::future<SearchInfo> future;
+    SearchInfo result;
+    bool collected;
+
+public:
+    SearchHandle()
+    {
+        engine = NULL;
+        collected = false;
+    }
+
+    ~SearchHandle()
+    {
+        if (engine)
+        {
+            stop();
+            wait();
+        }
+    }
+
+    // start searching in_board for in_color within limits
+    void start(Gomoku &in_engine, int in_board[][WIDTH], int in_color, const SearchLimits &limits)
+    {
+        if (engine)
+        {
+            stop();
+            wait();
+        }
+        engine = &in_engine;
+        collected = false;
+        board.assign(&in_board[0][0], &in_board[0][0] + HEIGHT * WIDTH);
+        engine->clearStop();
+        future = std::async(std::launch::async, [this, in_color, limits]()
+                            { return engine->search((int(*)[WIDTH])board.data(), in_color, limits); });
+    }
+
+    // true once the search has finished
+    bool done()
+    {
+        if (!engine)
+            return true;
+        return collected || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // best move / score / depth of the deepest completed iteration so far
+    SearchInfo poll()
+    {
+        if (collected)
+            return result;
+        return engine ? engine->currentInfo() : SearchInfo();
+    }
+
+    // wait up to ms milliseconds, return true if the search has finished
+    bool waitFor(long long ms)
+    {
+        if (collected)
+            return true;
+        return future.wait_for(std::chrono::milliseconds(ms)) == std::future_status::ready;
+    }
+
+    // block until the search has finished and return its result
+    SearchInfo wait()
+    {
+        if (!collected && future.valid())
+        {
+            result = future.get();
+            collected = true;
+            engine->clearStop();
+        }
+        return result;
+    }
+
+    // abort the search, wait() then returns the best move found so far
+    void stop()
+    {
+        if (engine && !collected)
+            engine->stop();
+    }
+};
+
+#endif // ASYNC_SEARCH
@@ -0,0 +1,492 @@
+#ifndef BOARD
+#define BOARD
+
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "nnue.h"
+#include "rng.h"
+
+// Padded board layout: the board is stored row by row in a flat array surrounded
+// by a border of OFF_BOARD cells. The border is as wide as the longest pattern
+// window (a five plus the cell before it), so a scan that starts on the board
+// never needs a bounds check and never leaves the array.
+const int BORDER = 5;
+const int PADDED_WIDTH = WIDTH + 2 * BORDER;
+const int PADDED_HEIGHT = HEIGHT + 2 * BORDER;
+const int PADDED_SIZE = PADDED_WIDTH * PADDED_HEIGHT;
+const int OFF_BOARD = 2; // neither empty nor a stone
+
+// direction
+int dx[] = {1, 1, 1, 0, -1, -1, -1, 0};
+int dy[] = {-1, 0, 1, 1, 1, -1, 0, -1};
+// index step of each direction above
+const int dstep[] = {PADDED_WIDTH - 1, PADDED_WIDTH, PADDED_WIDTH + 1, 1,
+                     -PADDED_WIDTH + 1, -PADDED_WIDTH - 1, -PADDED_WIDTH, -1};
+
+// direction pointing the other way
+const int opposite[] = {4, 6, 5, 7, 0, 2, 1, 3};
+
+// index step of the 4 lines: 6h, 3h, 5h, 1h
+const int axis_step[] = {PADDED_WIDTH, 1, PADDED_WIDTH + 1, -PADDED_WIDTH + 1};
+// direction of each line in dx / dy, the other half of the line is opposite[]
+const int axis_dir[] = {1, 3, 2, 4};
+
+inline int toIndex(int row, int col)
+{
+    return (row + BORDER) * PADDED_WIDTH + col + BORDER;
+}
+
+inline int indexRow(int index)
+{
+    return index / PADDED_WIDTH - BORDER;
+}
+
+inline int indexCol(int index)
+{
+    return index % PADDED_WIDTH - BORDER;
+}
+
+inline bool isStone(int value)
+{
+    return value == 1 || value == -1;
+}
+
+// copy a plain board into the padded layout
+inline void loadPadded(int in_board[][WIDTH], int padded[])
+{
+    for (int i = 0; i < PADDED_SIZE; ++i)
+        padded[i] = OFF_BOARD;
+    for (int row = 0; row < HEIGHT; ++row)
+    {
+        for (int col = 0; col < WIDTH; ++col)
+        {
+            padded[toIndex(row, col)] = in_board[row][col];
+        }
+    }
+}
+
+// Zobrist keys, one per cell and color plus one for black to move,
+// generated from a fixed seed so hashes are the same in every process
+// (saved caches and game records depend on it)
+const unsigned long long ZOBRIST_SEED = 0x9E3779B97F4A7C15ULL;
+
+struct ZobristTable
+{
+    unsigned long long keys[PADDED_SIZE][2];
+    unsigned long long side;
+
+    ZobristTable()
+    {
+        Rng rng(ZOBRIST_SEED);
+        for (int i = 0; i < PADDED_SIZE; ++i)
+        {
+            keys[i][0] = rng.next();
+            keys[i][1] = rng.next();
+        }
+        side = rng.next();
+    }
+
+    unsigned long long key(int index, int value) const
+    {
+        return keys[index][value > 0];
+    }
+};
+
+const ZobristTable zobrist;
+
+// Rectangle holding every stone, empty when top > bottom
+struct BoundingBox
+{
+    int top, bottom, left, right;
+};
+
+// Stones of one color next to an empty cell in one direction
+struct Run
+{
+    signed char color;
+    unsigned char length;
+};
+
+// Padded board with the stone count and bounding box kept up to date.
+// It also caches, for every empty cell and direction, the run of stones that
+// starts next to it. A stone only changes the runs of the first empty cell
+// past the stones on each side of it, so place/remove refresh at most 8 entries.
+class Board
+{
+private:
+    int cells[PADDED_SIZE];
+    int num_stones;
+    BoundingBox box;
+    unsigned long long hash;
+    Run runs[PADDED_SIZE][8];
+    const Network *network; // optional, its accumulator follows every place / remove
+    Accumulator acc;
+
+    // walk the run starting next to index in direction
+    void updateRun(int index, int direction)
+    {
+        int step = dstep[direction];
+        int value = cells[index + step];
+        Run &run = runs[index][direction];
+        run.color = isStone(value) ? value : 0;
+        run.length = 0;
+        if (!run.color)
+            return;
+        for (int next = index + step; cells[next] == value; next += step)
+            run.length++;
+    }
+
+    // refresh the runs that can see the cell index
+    void updateAround(int index)
+    {
+        for (int direction = 0; direction < 8; ++direction)
+        {
+            int step = dstep[direction];
+            int next = index + step;
+            while (isStone(cells[next]))
+                next += step;
+            if (cells[next] == 0)
+                updateRun(next, opposite[direction]);
+        }
+    }
+
+    // recompute the accumulator from scratch
+    void refreshAccumulator()
+    {
+        if (!network)
+            return;
+        network->reset(acc);
+        for (int row = 0; row < HEIGHT; ++row)
+        {
+            for (int col = 0; col < WIDTH; ++col)
+            {
+                int value = cells[toIndex(row, col)];
+                if (value != 0)
+                    network->add(acc, nnueFeature(row * WIDTH + col, value));
+            }
+        }
+    }
+
+public:
+    Board()
+    {
+        network = NULL;
+        int empty[HEIGHT][WIDTH] = {};
+        load(empty);
+    }
+
+    int operator[](int index) const
+    {
+        return cells[index];
+    }
+
+    const int *data() const
+    {
+        return cells;
+    }
+
+    int stones() const
+    {
+        return num_stones;
+    }
+
+    const BoundingBox &bounds() const
+    {
+        return box;
+    }
+
+    // attach (or detach with NULL) a network whose accumulator is kept up to date
+    void setNetwork(const Network *in_network)
+    {
+        network = in_network;
+        refreshAccumulator();
+    }
+
+    const Network *getNetwork() const
+    {
+        return network;
+    }
+
+    const Accumulator &accumulator() const
+    {
+        return acc;
+    }
+
+    // Zobrist hash of the position with side to move
+    unsigned long long key(int side) const
+    {
+        return side == -1 ? hash ^ zobrist.side : hash;
+    }
+
+    // run next to the empty cell index, length 0 when the neighbour is not a stone
+    const Run &run(int index, int direction) const
+    {
+        return runs[index][direction];
+    }
+
+    // length of the line color would own through the empty cell index along axis
+    int lineLength(int index, int axis, int in_color) const
+    {
+        const Run &forward = runs[index][axis_dir[axis]];
+        const Run &backward = runs[index][opposite[axis_dir[axis]]];
+        int length = 1;
+        if (forward.color == in_color)
+            length += forward.length;
+        if (backward.color == in_color)
+            length += backward.length;
+        return length;
+    }
+
+    // true when the line color owns through the empty cell index along axis,
+    // counting the empty cell extra (-1 for none) as color too, wins under Rule
+    template <class Rule>
+    bool winsWith(int index, int extra, int axis, int in_color) const
+    {
+        int step = axis_step[axis];
+        int length = 1, blocked = 0;
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            int cell = index + sign * step;
+            while (cells[cell] == in_color || cell == extra)
+            {
+                length++;
+                cell += sign * step;
+            }
+            if (cells[cell] != 0)
+                blocked++;
+        }
+        return Rule::wins(length, blocked);
+    }
+
+    // true when color playing the empty cell index makes a winning line
+    template <class Rule>
+    bool makesFive(int index, int in_color) const
+    {
+        for (int axis = 0; axis < 4; ++axis)
+        {
+            if (lineLength(index, axis, in_color) >= 5 && winsWith<Rule>(index, -1, axis, in_color))
+                return true;
+        }
+        return false;
+    }
+
+    // true when color playing the empty cell index leaves a win to complete:
+    // some window of 5 through it holds 3 stones of color and one other empty cell
+    // that then makes a winning line
+    template <class Rule>
+    bool makesFour(int index, int in_color) const
+    {
+        for (int axis = 0; axis < 4; ++axis)
+        {
+            int step = axis_step[axis];
+            for (int start = index - 4 * step; start != index + step; start += step)
+            {
+                int own = 0, empty = 0, other = -1;
+                for (int i = 0; i < 5; ++i)
+                {
+                    int cell = start + i * step;
+                    int value = cells[cell];
+                    if (value == in_color)
+                        own++;
+                    else if (value == 0)
+                    {
+                        empty++;
+                        if (cell != index)
+                            other = cell;
+                    }
+                }
+                if (own == 3 && empty == 2 && winsWith<Rule>(other, index, axis, in_color))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // color of a winning line on the board, 0 when there is none.
+    // Only the first stone of every line is walked
+    template <class Rule>
+    int winner() const
+    {
+        for (int row = box.top; row <= box.bottom; ++row)
+        {
+            for (int col = box.left; col <= box.right; ++col)
+            {
+                int index = toIndex(row, col);
+                int value = cells[index];
+                if (!isStone(value))
+                    continue;
+                for (int axis = 0; axis < 4; ++axis)
+                {
+                    int step = axis_step[axis];
+                    if (cells[index - step] == value)
+                        continue;
+                    int end = index + step;
+                    while (cells[end] == value)
+                        end += step;
+                    int length = (end - index) / step;
+                    if (length >= 5 && Rule::wins(length, (cells[index - step] != 0) + (cells[end] != 0)))
+                        return value;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // empty cells where color makes a winning line, they all touch the bounding box
+    template <class Rule>
+    void fiveSquares(int in_color, std::vector<int> &out) const
+    {
+        out.clear();
+        int last_row = std::min(HEIGHT - 1, box.bottom + 1), last_col = std::min(WIDTH - 1, box.right + 1);
+        for (int row = std::max(0, box.top - 1); row <= last_row; ++row)
+        {
+            for (int col = std::max(0, box.left - 1); col <= last_col; ++col)
+            {
+                int index = toIndex(row, col);
+                if (cells[index] == 0 && makesFive<Rule>(index, in_color))
+                    out.push_back(index);
+            }
+        }
+    }
+
+    // true when color playing the empty cell index makes an open three:
+    // some window of 6 through it has empty ends and 2 stones of color plus one empty cell inside
+    bool makesOpenThree(int index, int in_color) const
+    {
+        for (int axis = 0; axis < 4; ++axis)
+        {
+            int step = axis_step[axis];
+            for (int start = index - 4 * step; start != index; start += step)
+            {
+                if (cells[start] != 0 || cells[start + 5 * step] != 0)
+                    continue;
+                int own = 0, empty = 0;
+                for (int i = 1; i < 5; ++i)
+                {
+                    int value = cells[start + i * step];
+                    if (value == in_color)
+                        own++;
+                    else if (value == 0)
+                        empty++;
+                }
+                if (own == 2 && empty == 2)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // empty cells where color makes a four, in index order. Every window of 5 with
+    // 3 stones of color and 2 empty cells is visited once, from its first stone;
+    // each empty cell counts when the other one then makes a winning line.
+    template <class Rule>
+    void fourMoves(int in_color, std::vector<int> &out) const
+    {
+        out.clear();
+        for (int row = box.top; row <= box.bottom; ++row)
+        {
+            for (int col = box.left; col <= box.right; ++col)
+            {
+                int index = toIndex(row, col);
+                if (cells[index] != in_color)
+                    continue;
+                for (int axis = 0; axis < 4; ++axis)
+                {
+                    int step = axis_step[axis];
+                    for (int start = index - 4 * step; start != index + step; start += step)
+                    {
+                        int own = 0, empty = 0, first = -1, gaps[2];
+                        for (int i = 0; i < 5; ++i)
+                        {
+                            int value = cells[start + i * step];
+                            if (value == in_color)
+                            {
+                                own++;
+                                if (first == -1)
+                                    first = start + i * step;
+                            }
+                            else if (value == 0)
+                            {
+                                if (empty < 2)
+                                    gaps[empty] = start + i * step;
+                                empty++;
+                            }
+                        }
+                        if (own != 3 || empty != 2 || first != index)
+                            continue;
+                        if (winsWith<Rule>(gaps[1], gaps[0], axis, in_color))
+                            out.push_back(gaps[0]);
+                        if (winsWith<Rule>(gaps[0], gaps[1], axis, in_color))
+                            out.push_back(gaps[1]);
+                    }
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    void load(int in_board[][WIDTH])
+    {
+        loadPadded(in_board, cells);
+        num_stones = 0;
+        hash = 0;
+        box.top = HEIGHT;
+        box.bottom = -1;
+        box.left = WIDTH;
+        box.right = -1;
+        for (int row = 0; row < HEIGHT; ++row)
+        {
+            for (int col = 0; col < WIDTH; ++col)
+            {
+                int index = toIndex(row, col);
+                if (cells[index] != 0)
+                {
+                    num_stones++;
+                    hash ^= zobrist.key(index, cells[index]);
+                    box.top = std::min(box.top, row);
+                    box.bottom = std::max(box.bottom, row);
+                    box.left = std::min(box.left, col);
+                    box.right = std::max(box.right, col);
+                    continue;
+                }
+                for (int direction = 0; direction < 8; ++direction)
+                    updateRun(index, direction);
+            }
+        }
+        refreshAccumulator();
+    }
+
+    // put a stone and grow the bounding box
+    void place(int index, int value)
+    {
+        int row = indexRow(index), col = indexCol(index);
+        cells[index] = value;
+        num_stones++;
+        hash ^= zobrist.key(index, value);
+        if (network)
+            network->add(acc, nnueFeature(row * WIDTH + col, value));
+        box.top = std::min(box.top, row);
+        box.bottom = std::max(box.bottom, row);
+        box.left = std::min(box.left, col);
+        box.right = std::max(box.right, col);
+        updateAround(index);
+    }
+
+    // take back a stone, saved is the bounding box before it was placed
+    void remove(int index, const BoundingBox &saved)
+    {
+        hash ^= zobrist.key(index, cells[index]);
+        if (network)
+            network->sub(acc, nnueFeature(indexRow(index) * WIDTH + indexCol(index), cells[index]));
+        cells[index] = 0;
+        num_stones--;
+        box = saved;
+        for (int direction = 0; direction < 8; ++direction)
+            updateRun(index, direction);
+        updateAround(index);
+    }
+};
+
+#endif // BOARD
@@ -3,40 +3,44 @@
 
 #include <iostream>
 #include <stdlib.h>
+#include <vector>
+#include <utility>
 #include "config.h"
+#include "board.h"
+#include "rng.h"
 
-Point check_win(int board_game[][WIDTH], int player_id);
-Point defend(int board_game[][WIDTH], int player_id);
-Point attack(int board_game[][WIDTH], int player_id);
-Point check_n_tile(int board_game[][WIDTH], int player_id, int n);
+Point check_win(int board_game[][WIDTH], int player_id, Rng &rng);
+Point defend(int board_game[][WIDTH], int player_id, Rng &rng);
+Point attack(int board_game[][WIDTH], int player_id, Rng &rng);
+Point check_n_tile(int board_game[][WIDTH], int player_id, int n, Rng &rng);
 
-// player_id = 1 || -1
-Point player_rand(int board_game[][WIDTH], int player_id){
+// player_id = 1 || -1, every random choice is drawn from rng
+Point player_rand(int board_game[][WIDTH], int player_id, Rng &rng){
     int row, col;
-    row = rand() % HEIGHT;
-    col = rand() % WIDTH;
+    row = rng.below(HEIGHT);
+    col = rng.below(WIDTH);
     return Point(row, col);
 }
 
-Point player_baseline(int board_game[][WIDTH], int player_id){
-    Point p = check_win(board_game, player_id);
+Point player_baseline(int board_game[][WIDTH], int player_id, Rng &rng){
+    Point p = check_win(board_game, player_id, rng);
     if(p.x != -1 && p.y != -1){
         return p;
     } else {
-        p = defend(board_game, player_id);
+        p = defend(board_game, player_id, rng);
         if(p.x != -1 && p.y != -1){
             return p;
         } else {
-            return attack(board_game, player_id);
+            return attack(board_game, player_id, rng);
         }
     }
 }
 
-Point check_win(int board_game[][WIDTH], int player_id){
-    return check_n_tile(board_game, player_id, 4);
+Point check_win(int board_game[][WIDTH], int player_id, Rng &rng){
+    return check_n_tile(board_game, player_id, 4, rng);
 }
 
-Point defend(int board_game[][WIDTH], int player_id){
+Point defend(int board_game[][WIDTH], int player_id, Rng &rng){
 //    Pointp p = check_n_tile(board_game, -player_id, 4);
 //    if(p.x != -1 || p.y != -1) return p;
 //    else {
@@ -44,20 +48,20 @@ Point defend(int board_game[][WIDTH], int player_id){
 //        if(p.x != -1 || p.y != -1) return p;
 //    }
 //    return Point(-1, -1);
-    return check_n_tile(board_game, -player_id, 4);
+    return check_n_tile(board_game, -player_id, 4, rng);
 }
 
-Point attack(int board_game[][WIDTH], int player_id){
-    Point p = check_n_tile(board_game, player_id, 3);
+Point attack(int board_game[][WIDTH], int player_id, Rng &rng){
+    Point p = check_n_tile(board_game, player_id, 3, rng);
     if(p.x != -1 && p.y != -1) return p;
 
-    p = check_n_tile(board_game, -player_id, 3);
+    p = check_n_tile(board_game, -player_id, 3, rng);
     if(p.x != -1 && p.y != -1) return p;
 
-    p = check_n_tile(board_game, player_id, 2);
+    p = check_n_tile(board_game, player_id, 2, rng);
     if(p.x != -1 && p.y != -1) return p;
 
-    p = check_n_tile(board_game, player_id, 1);
+    p = check_n_tile(board_game, player_id, 1, rng);
     if(p.x != -1 && p.y != -1) return p;
 
     for(int i=0; i < HEIGHT; i++){
@@ -71,88 +75,88 @@ Point attack(int board_game[][WIDTH], int player_id){
     return Point(HEIGHT/2, WIDTH/2);
 }
 
-Point check_n_tile(int board_game[][WIDTH], int player_id, int n){
-    int check_6h = 1, check_3h = 1, check_5h = 1, check_1h = 1;
-    Point temp(-1, -1);
-    Point posible_moves[8];
+// moves check_n_tile chooses from: for the first stone (row by row) of player_id
+// that starts a line of n, the empty ends of its lines in the order 6h, 3h, 5h, 1h.
+// A move listed twice is twice as likely. forced is set when an open three's
+// first end is returned without a random draw. board is padded, moves are indexes
+int n_tile_moves(const int board[], int player_id, int n, int moves[8], bool &forced){
+    forced = false;
     int p_moves = 0;
     for(int i=0; i < HEIGHT; i++){
         for(int j=0; j < WIDTH; j++){
-            if(board_game[i][j] != player_id) continue;
-
-            check_6h = 1, check_3h = 1, check_5h = 1, check_1h = 1;
-            for(int k = 1; k < n; k++){
-                if(board_game[i][j] == board_game[i+k][j]) check_6h++;
-                if(board_game[i][j] == board_game[i][j+k]) check_3h++;
-                if(board_game[i][j] == board_game[i+k][j+k]) check_5h++;
-                if(board_game[i][j] == board_game[i-k][j+k]) check_1h++;
-            }
-
-            if(check_6h == n){
-                if(n == 3){
-                    if(board_game[i-1][j] == 0 && board_game[i+n][j] == 0) return Point(i-1, j);
-                }
-                if(board_game[i-1][j] == 0) {
-                    posible_moves[p_moves] = Point(i-1, j);
-                    p_moves++;
-                }
-                if(board_game[i+n][j] == 0) {
-                    posible_moves[p_moves] = Point(i+n, j);
-                    p_moves++;
-                }
-
-            }
-            if(check_3h == n){
-                if(n == 3){
-                    if(board_game[i][j-1] == 0 && board_game[i][j+n] == 0) return Point(i, j-1);
+            int index = toIndex(i, j);
+            if(board[index] != player_id) continue;
+
+            for(int axis = 0; axis < 4; axis++){
+                int step = axis_step[axis];
+                int check = 1;
+                for(int k = 1; k < n; k++){
+                    if(board[index] == board[index + k*step]) check++;
                 }
+                if(check != n) continue;
 
-                if(board_game[i][j-1] == 0) {
-                    posible_moves[p_moves] = Point(i, j-1);
-                    p_moves++;
-                }
-                if(board_game[i][j+n] == 0) {
-                    posible_moves[p_moves] = Point(i, j+n);
-                    p_moves++;
+                if(n == 3 && board[index - step] == 0 && board[index + n*step] == 0){
+                    moves[0] = index - step;
+                    forced = true;
+                    return 1;
                 }
-
+                if(board[index - step] == 0) moves[p_moves++] = index - step;
+                if(board[index + n*step] == 0) moves[p_moves++] = index + n*step;
             }
-            if(check_5h == n){
-                if(n == 3){
-                    if(board_game[i-1][j-1] == 0 && board_game[i+n][j+n] == 0) return Point(i-1, j-1);
-                }
 
-                if(board_game[i-1][j-1] == 0) {
-                    posible_moves[p_moves] = Point(i-1, j-1);
-                    p_moves++;
-                }
-                if(board_game[i+n][j+n] == 0) {
-                    posible_moves[p_moves] = Point(i+n, j+n);
-                    p_moves++;
-                }
+            if(p_moves > 0) return p_moves;
+        }
+    }
+    return 0;
+}
 
-            }
-            if(check_1h == n){
-                if(n == 3){
-                    if(board_game[i+1][j-1] == 0 && board_game[i-n][j+n] == 0) return Point(i+1, j-1);
-                }
-                if(board_game[i+1][j-1] == 0) {
-                    posible_moves[p_moves] = Point(i+1, j-1);
-                    p_moves++;
-                }
-                if(board_game[i-n][j+n] == 0) {
-                    posible_moves[p_moves] = Point(i-n, j+n);
-                    p_moves++;
-                }
+Point check_n_tile(int board_game[][WIDTH], int player_id, int n, Rng &rng){
+    // padded copy, the border cells stop every scan at the edge of the board
+    int board[PADDED_SIZE];
+    loadPadded(board_game, board);
+    int moves[8];
+    bool forced;
+    int p_moves = n_tile_moves(board, player_id, n, moves, forced);
+    if(p_moves == 0) return Point(-1, -1);
+    int index = forced ? moves[0] : moves[rng.below(p_moves)];
+    return Point(indexRow(index), indexCol(index));
+}
 
+// probability of every legal move player_baseline can play on the padded board.
+// Illegal answers are dropped since the game asks again; an empty policy means
+// the baseline can't produce a legal move and loses
+void baseline_policy(const int board[], int player_id, std::vector<std::pair<int, double>> &policy){
+    policy.clear();
+    // the cascade of player_baseline: win, defend, then attack
+    const int stages[6][2] = {{1, 4}, {-1, 4}, {1, 3}, {-1, 3}, {1, 2}, {1, 1}};
+    int moves[8];
+    bool forced;
+    for(int stage = 0; stage < 6; stage++){
+        int p_moves = n_tile_moves(board, stages[stage][0] * player_id, stages[stage][1], moves, forced);
+        if(p_moves == 0) continue;
+        for(int i = 0; i < p_moves; i++){
+            double weight = 1.0 / p_moves;
+            bool merged = false;
+            for(auto &item : policy){
+                if(item.first == moves[i]){
+                    item.second += weight;
+                    merged = true;
+                }
             }
+            if(!merged) policy.push_back(std::make_pair(moves[i], weight));
+        }
+        return;
+    }
 
-            if(p_moves > 0){
-                return posible_moves[rand()%p_moves];
-            }
+    // below the first opponent stone, or the center
+    int index = -1;
+    for(int i=0; i < HEIGHT && index == -1; i++){
+        for(int j=0; j < WIDTH && index == -1; j++){
+            if(board[toIndex(i, j)] == -player_id) index = toIndex(i+1, j);
         }
     }
-    return Point(-1, -1);
+    if(index == -1) index = toIndex(HEIGHT/2, WIDTH/2);
+    if(board[index] == 0) policy.push_back(std::make_pair(index, 1.0));
 }
 
 #endif // BOTBASELINE
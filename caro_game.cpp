@@ -1,19 +1,24 @@
 #include <iostream>
 #include <windows.h>
 #include <conio.h>
-#include <stdlib.h>     /* srand, rand */
+#include <stdlib.h>
 #include <time.h>       /* time */
 #include <unistd.h> // sleep function
 #include <vector>
+#include <chrono>
 
 #include "config.h"
+#include "board.h"
 #include "botbaseline.h"
 #include "custom_bot.h"
+#include "async_search.h"
+#include "rng.h"
 
 using namespace std;
 
 int board_game[HEIGHT][WIDTH];
 Point win_path[5];
+Rng rng = Rng::fromClock(); // new games on every run, Rng(RANDOM_SEED) replays the same ones
 
 void init_board_game();
 void go_to_xy(Point p);
@@ -26,10 +31,9 @@ Point player1_run();
 Point player2_run();
 
 void draw_background();
+bool in_board(Point p);
 
 int main(){
-    srand (time(NULL));
-
     set_text_color(WHITE_COLOR);
     char c;
     do{
@@ -52,6 +56,10 @@ void init_board_game(){
     }
 }
 
+bool in_board(Point p){
+    return p.x >= 0 && p.x < HEIGHT && p.y >= 0 && p.y < WIDTH;
+}
+
 void set_text_color(int color)
 {
     SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), color);
@@ -97,70 +105,30 @@ void draw_tile(Point p, int color){
     }
 }
 
+// the winner under the bot's rule (CaroRule), walking every line from its first stone
+// as Board::winner does; win_path gets the first five stones of the winning line
 int who_win(){
-    int win = 0; // 1. thang . 0 la chua thang
+    // padded copy, the border cells count as blocked ends
+    int board[PADDED_SIZE];
+    loadPadded(board_game, board);
     for(int i=0; i < HEIGHT; i++){
         for(int j=0; j < WIDTH; j++){
-            if(board_game[i][j] == 0) continue;
-            // check huong 6h, code goi y
-            if((board_game[i][j]==board_game[i+1][j])&&(board_game[i][j]==board_game[i+2][j])
-               &&(board_game[i][j]==board_game[i+3][j])&&(board_game[i+4][j]==board_game[i][j])){
-                if(board_game[i-1][j] == 0 || board_game[i+5][j] == 0)
-                    win = 1;
-                else win = 0;
-
-                if(win == 1){
-                    for(int k=0; k <= 4; k++){
-                        win_path[k] = Point(BLOCK_RATIO*j, i+k);
-                    }
-                    return board_game[i][j];
-                }
-            }
-            // check huong 3h
-            // your code here
-            if((board_game[i][j]==board_game[i][j+1])&&(board_game[i][j]==board_game[i][j+2])
-               &&(board_game[i][j]==board_game[i][j+3])&&(board_game[i][j+4]==board_game[i][j])){
-                if(board_game[i][j-1] == 0 || board_game[i][j+5] == 0)
-                    win = 1;
-                else win = 0;
-
-                if(win == 1){
-                    for(int k=0; k <= 4; k++){
-                        win_path[k] = Point(BLOCK_RATIO*j + k, i);
-                    }
-                    return board_game[i][j];
-                }
-            }
-
-            // check huong 5h
-           	// your code here
-            if((board_game[i][j]==board_game[i+1][j+1])&&(board_game[i][j]==board_game[i+2][j+2])
-               &&(board_game[i][j]==board_game[i+3][j+3])&&(board_game[i+4][j+4]==board_game[i][j])){
-                if(board_game[i-1][j-1] == 0 || board_game[i+5][j+5] == 0)
-                    win = 1;
-                else win = 0;
-
-                if(win == 1){
-                    for(int k=0; k <= 4; k++){
-                        win_path[k] = Point(BLOCK_RATIO*j + k, i + k);
-                    }
-                    return board_game[i][j];
-                }
-            }
-            // check huong 1h
-            // your code here
-            if((board_game[i][j]==board_game[i-1][j+1])&&(board_game[i][j]==board_game[i-2][j+2])
-               &&(board_game[i][j]==board_game[i-3][j+3])&&(board_game[i-4][j+4]==board_game[i][j])){
-                if(board_game[i+1][j-1] == 0 || board_game[i-5][j+5] == 0)
-                    win = 1;
-                else win = 0;
-
-                if(win == 1){
-                    for(int k=0; k <= 4; k++){
-                        win_path[k] = Point(BLOCK_RATIO*j + k, i - k);
-                    }
-                    return board_game[i][j];
+            int index = toIndex(i, j);
+            int value = board[index];
+            if(!isStone(value)) continue;
+            // check 4 huong: 6h, 3h, 5h, 1h
+            for(int d = 0; d < 4; d++){
+                int step = axis_step[d];
+                if(board[index-step] == value) continue;
+                int end = index + step;
+                while(board[end] == value) end += step;
+                int length = (end - index) / step;
+                if(!CaroRule::wins(length, (board[index-step] != 0) + (board[end] != 0))) continue;
+                for(int k=0; k <= 4; k++){
+                    int row = indexRow(index+k*step), col = indexCol(index+k*step);
+                    win_path[k] = Point(BLOCK_RATIO*col, row);
                 }
+                return value;
             }
         }
     }
@@ -169,17 +137,36 @@ int who_win(){
 }
 
 Gomoku gomoku_bot;
+SearchHandle gomoku_search;
+TimeManager gomoku_time;
+long long gomoku_clock = GAME_TIME; // milisecond left on the bot's game clock
+
+// run the bot in the background on its game clock, MOVE_TIME stays the hard limit of a move
+Point gomoku_run(int player_id){
+    SearchLimits limits;
+    limits.depth = MAX_DEPTH;
+    limits.time_ms = MOVE_TIME;
+    limits.clock = &gomoku_time;
+    gomoku_time.setClock(gomoku_clock, GAME_INCREMENT);
+    auto start = chrono::steady_clock::now();
+    gomoku_search.start(gomoku_bot, board_game, player_id, limits);
+    if(!gomoku_search.waitFor(MOVE_TIME)) gomoku_search.stop();
+    Point best = gomoku_search.wait().best;
+    gomoku_clock += GAME_INCREMENT - chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    if(gomoku_clock < 0) gomoku_clock = 0;
+    return best;
+}
 
 Point player1_run(){
-//    return player_rand(board_game, 1);
-    // return gomoku_bot.nextMove(board_game, 1);
-    return player_baseline(board_game, 1);
+//    return player_rand(board_game, 1, rng);
+    // return gomoku_run(1);
+    return player_baseline(board_game, 1, rng);
 }
 
 Point player2_run(){
-//    return player_rand(board_game, -1);
-    return gomoku_bot.nextMove(board_game, -1);
-    // return player_baseline(board_game, -1);
+//    return player_rand(board_game, -1, rng);
+    return gomoku_run(-1);
+    // return player_baseline(board_game, -1, rng);
 }
 
 void play_game(){
@@ -192,6 +179,7 @@ void play_game(){
         // init_board_game();
         turn_player1 = true;
         turn_limit = 3000;
+        gomoku_clock = GAME_TIME;
 
         while(turn_limit > 0){
             repeat_pos = 5;
@@ -204,7 +192,7 @@ void play_game(){
                         goto reset_game;
                     }
                     repeat_pos--;
-                }while(board_game[position.x][position.y] != 0);
+                }while(!in_board(position) || board_game[position.x][position.y] != 0);
 
                 board_game[position.x][position.y] = 1;
                 draw_tile(Point(BLOCK_RATIO*position.y, position.x), WHITE_COLOR);
@@ -217,7 +205,7 @@ void play_game(){
                         goto reset_game;
                     }
                     repeat_pos--;
-                }while(board_game[position.x][position.y] != 0);
+                }while(!in_board(position) || board_game[position.x][position.y] != 0);
                 board_game[position.x][position.y] = -1;
                 draw_tile(Point(BLOCK_RATIO*position.y, position.x), RED_COLOR);
             }
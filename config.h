@@ -29,5 +29,19 @@ const int HEIGHT = 30;
 const int PAUSE_TIME = 1000; // milisecond
 const int BLOCK_RATIO = 1;
 const int DEPTH = 1;
+const int MOVE_TIME = 3000; // milisecond, hard limit for a bot move
+const int GAME_TIME = 300000; // milisecond, game clock of the bot, budgeted per move by time_manager.h
+const int GAME_INCREMENT = 1000; // milisecond added to the clock after every bot move
+const int MAX_DEPTH = 64; // deepest iteration of a search on a game clock, the clock stops it first
+const int TT_SIZE = 1 << 16; // transposition table entries
+const int SOLVER_NODES = 20000; // proof-number solver limits per move
+const int SOLVER_MEMORY = 8 << 20; // bytes
+const int QUIESCENCE_DEPTH = 8; // plies of forcing moves after the search horizon
+const int QUIESCENCE_NODES = 20000; // quiescence nodes per search
+const int POOL_SLICE_NODES = 256; // nodes a pooled search runs before yielding its thread
+const int POOL_STACK_SIZE = 256 << 10; // bytes of address space per running pooled search
+const int RANDOM_SEED = 1; // seed of an Rng given none; tests pass their own, caro_game takes the clock
+const int NODES_PER_MS = 300; // node budget per millisecond of a time limit in deterministic mode
+const int CACHE_ENTRIES = 1 << 20; // persistent position cache entries, 16 bytes each
 
 #endif // CONFIG
@@ -1,17 +1,37 @@
+#ifndef CUSTOM_BOT
+#define CUSTOM_BOT
+
 #include <vector>
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cmath>
 #include "config.h"
+#include "board.h"
+#include "rules.h"
+#include "transposition.h"
+#include "pn_solver.h"
+#include "botbaseline.h"
+#include "position_cache.h"
+#include "time_manager.h"
 
 // constants
 const int INF = (int)1e9;
 const int winScore = (int)1e8;
 const int winGurantee = (int)1e6;
+const int provenScore = (int)5e8; // white's score of a position proven won by white
+
+// quiescence modes: which forcing moves are extended past the horizon
+const int QUIESCENCE_OFF = 0;
+const int QUIESCENCE_FOURS = 1;
+const int QUIESCENCE_THREES = 2; // fours and open threes
 
-// direction
-int dx[] = {1, 1, 1, 0, -1, -1, -1, 0};
-int dy[] = {-1, 0, 1, 1, 1, -1, 0, -1};
+// opponent models: how the replies of the other side are searched
+const int OPPONENT_MINIMAX = 0;
+const int OPPONENT_BASELINE = 1; // expectimax over the moves player_baseline can play
 
 // Candidate Point Struct
 struct Candidate
@@ -29,176 +49,227 @@ struct Candidate
     }
 };
 
-class Gomoku
+// Budget of one search, 0 means unlimited for nodes and time_ms.
+// With a clock the time_manager.h budgets of the move apply on top of them
+struct SearchLimits
 {
-private:
-    std::vector<std::vector<int>> board; // board information
-    int color;                           // current color
-    int num_occupied;                    // number of occupied to trigger the earlyMove function
+    int depth;
+    long long nodes;
+    long long time_ms;
+    TimeManager *clock; // NULL when the game has no clock
+    SearchLimits()
+    {
+        depth = DEPTH;
+        nodes = 0;
+        time_ms = 0;
+        clock = NULL;
+    }
+};
+
+// Root move with its score, for analysis
+struct RootMove
+{
+    Point point;
+    double score;
+};
+
+// Result of the deepest completed iteration
+struct SearchInfo
+{
+    Point best;
+    double score;
+    int depth;
+    long long nodes;
+    bool finished;
+    SearchInfo()
+    {
+        best = Point(-1, -1);
+        score = 0;
+        depth = 0;
+        nodes = 0;
+        finished = false;
+    }
+};
 
-    // check if coord (row, col) is in the board or not
-    bool inBoard(int row, int col)
+// score of count consecutive stones with blocked closed ends, isNext when their color moves next
+template <class Rule>
+constexpr int patternScore(int count, int blocked, bool isNext)
+{
+    // a line that wins under Rule, or one that never can
+    if (count >= 5)
+        return Rule::wins(count, blocked) ? winScore : 0;
+    if (blocked == 2)
+        // we can't win in this situation
+        return 0;
+    switch (count)
     {
-        return (row >= 0 && row < HEIGHT && col >= 0 && col < WIDTH);
+    case 4:
+        if (isNext)
+            // only just need a move to win this game
+            return winGurantee;
+        // The opponents can't stop you to win
+        if (blocked == 0)
+            return winGurantee / 4;
+        // The opponents can stop you to win, but it's still good for you
+        return 200;
+    case 3:
+        if (blocked == 0)
+            // You only need a move to win this situation, or the opponents can stop you
+            return isNext ? winGurantee / 10 : 200;
+        // This situation is not really good, so the point for it is low
+        return isNext ? 10 : 5;
+    case 2:
+        // This situation is not really good, so the point for it is low
+        if (blocked == 0)
+            return isNext ? 7 : 5;
+        return 3;
     }
+    return 1;
+}
+
+// patternScore of one rule computed at compile time, counts above 6 score like 6
+const int PATTERN_MAX_COUNT = 6;
+
+template <class Rule>
+struct PatternTable
+{
+    int score[PATTERN_MAX_COUNT + 1][3][2];
+
+    constexpr PatternTable() : score()
+    {
+        for (int count = 1; count <= PATTERN_MAX_COUNT; ++count)
+            for (int blocked = 0; blocked < 3; ++blocked)
+                for (int next = 0; next < 2; ++next)
+                    score[count][blocked][next] = patternScore<Rule>(count, blocked, next == 1);
+    }
+};
+
+// The engine, compiled once per win rule (rules.h)
+template <class Rule>
+class GomokuEngine
+{
+private:
+    Board board;     // padded board information, scans are limited to its bounding box grown by one cell
+    int color;       // current color
+    int num_occupied; // number of occupied to trigger the earlyMove function
+    int depth;       // search depth used by nextMove
+    long long nodes; // number of searched nodes since construction
+    bool use_solver; // run the proof-number solver when we can make a four
+    int quiescence;  // QUIESCENCE_* mode
+    int opponent_model; // OPPONENT_* mode
+    bool deterministic; // node budgets instead of the clock, no state kept between searches
+    long long qnodes; // quiescence nodes of the current search
+    TranspositionTable tt; // results proven by the solver
+    PositionCache *cache; // shared root results, NULL when not used
+
+    // search control, stop_flag may be written from another thread
+    std::atomic<bool> stop_flag;
+    bool aborted;
+    long long node_limit;
+    bool has_deadline;
+    std::chrono::steady_clock::time_point deadline;
+    std::mutex info_mutex;
+    SearchInfo info;
+
+    // cooperative scheduling, yield_hook(yield_arg) is called every yield_every nodes
+    void (*yield_hook)(void *);
+    void *yield_arg;
+    long long yield_every;
+    long long next_yield;
+
+    static constexpr PatternTable<Rule> patterns = PatternTable<Rule>();
 
     // return the score of count consecutive piles with blocked - number of sides that is blocked, isNext is True or False
     int getConsecutiveSetScore(int count, int blocked, bool isNext)
     {
-        if (blocked == 2 && count < 5)
-            // we can't win in this situation
-            return 0;
-        switch (count)
-        {
-        case 5:
-            // won already
-            return winScore;
-        case 4:
-            if (isNext)
-                // only just need a move to win this game
-                return winGurantee;
-            else
-            {
-                // The opponents can't stop you to win
-                if (blocked == 0)
-                    return winGurantee / 4;
-                // The opponents can stop you to win, but it's still good for you
-                else
-                    return 200;
-            }
-        case 3:
-            if (blocked == 0)
-            {
-                if (isNext)
-                    // You only need a move to win this situation
-                    return winGurantee / 10;
-                else
-                    // The opponents can stop you to win, but it's still good for you
-                    return 200;
-            }
-            else
-            {
-                // This situation is not really good, so the point for it is low
-                if (isNext)
-                    return 10;
-                else
-                    return 5;
-            }
-        case 2:
-            // This situation is not really good, so the point for it is low
-            if (blocked == 0)
-            {
-                if (isNext)
-                    return 7;
-                else
-                    return 5;
-            }
-            else
+        return patterns.score[count < PATTERN_MAX_COUNT ? count : PATTERN_MAX_COUNT][blocked][isNext];
+    }
+
+    // true if some empty cell makes a winning line for either color, read from the run cache
+    bool hasFiveThreat()
+    {
+        const BoundingBox &box = board.bounds();
+        int last_x = std::min(HEIGHT - 1, box.bottom + 1), last_y = std::min(WIDTH - 1, box.right + 1);
+        for (int row = std::max(0, box.top - 1); row <= last_x; ++row)
+        {
+            for (int col = std::max(0, box.left - 1); col <= last_y; ++col)
             {
-                return 3;
+                int index = toIndex(row, col);
+                if (board[index] == 0 && (board.makesFive<Rule>(index, 1) || board.makesFive<Rule>(index, -1)))
+                    return true;
             }
-        case 1:
-            // This situation is not really good, so the point for it is low
-            return 1;
         }
-        // Have more 5 consecutive piles? so good!
-        return winScore * 2;
+        return false;
     }
 
     Point finishMove()
     {
-        for (int row = 0; row < HEIGHT; ++row)
+        // a winning window always has an empty cell that makes a winning line
+        if (!hasFiveThreat())
+            return Point(-1, -1);
+        const BoundingBox &box = board.bounds();
+        for (int row = box.top; row <= box.bottom; ++row)
         {
-            for (int col = 0; col < WIDTH; ++col)
+            for (int col = box.left; col <= box.right; ++col)
             {
-                int value = board[row][col];
+                int index = toIndex(row, col);
+                int value = board[index];
                 if (value != color)
                     continue;
                 for (int direction = 0; direction < 8; ++direction)
                 {
-                    int block = 0;
-                    int new_x = row - dx[direction], new_y = col - dy[direction];
-                    if (inBoard(new_x, new_y) && board[new_x][new_y] == -value)
-                        block++;
-                    new_x = row + 5 * dx[direction];
-                    new_y = col + 5 * dy[direction];
-                    if (inBoard(new_x, new_y) && board[new_x][new_y] == -value)
-                        block++;
-                    if (block == 2)
-                        continue;
+                    int step = dstep[direction];
                     bool ok = true;
                     int num = 0;
                     for (int i = 0; i < 5; ++i)
                     {
-                        new_x = row + i * dx[direction];
-                        new_y = col + i * dy[direction];
-                        if (inBoard(new_x, new_y))
-                        {
-                            if (board[new_x][new_y] == value)
-                                num++;
-                            else if (board[new_x][new_y] == -value)
-                                ok = false;
-                        }
-                        else
+                        int cell = board[index + i * step];
+                        if (cell == value)
+                            num++;
+                        else if (cell != 0)
                             ok = false;
                     }
                     if (ok && num == 4)
                     {
                         for (int i = 0; i < 5; ++i)
                         {
-                            new_x = row + i * dx[direction];
-                            new_y = col + i * dy[direction];
-                            if (!board[new_x][new_y])
-                                return Point(new_x, new_y);
+                            // whether the completed line wins (blocked ends, overlines) is up to the rule
+                            if (!board[index + i * step] && board.makesFive<Rule>(index + i * step, value))
+                                return Point(row + i * dx[direction], col + i * dy[direction]);
                         }
                     }
                 }
             }
         }
 
-        for (int row = 0; row < HEIGHT; ++row)
+        for (int row = box.top; row <= box.bottom; ++row)
         {
-            for (int col = 0; col < WIDTH; ++col)
+            for (int col = box.left; col <= box.right; ++col)
             {
-                int value = board[row][col];
+                int index = toIndex(row, col);
+                int value = board[index];
                 if (value != -color)
                     continue;
                 for (int direction = 0; direction < 8; ++direction)
                 {
-                    int block = 0;
-                    int new_x = row - dx[direction], new_y = col - dy[direction];
-                    if (inBoard(new_x, new_y) && board[new_x][new_y] == -value)
-                        block++;
-                    new_x = row + 5 * dx[direction];
-                    new_y = col + 5 * dy[direction];
-                    if (inBoard(new_x, new_y) && board[new_x][new_y] == -value)
-                        block++;
-                    if (block == 2)
-                        continue;
+                    int step = dstep[direction];
                     bool ok = true;
                     int num = 0;
                     for (int i = 0; i < 5; ++i)
                     {
-                        new_x = row + i * dx[direction];
-                        new_y = col + i * dy[direction];
-                        if (inBoard(new_x, new_y))
-                        {
-                            if (board[new_x][new_y] == value)
-                                num++;
-                            else if (board[new_x][new_y] == -value)
-                                ok = false;
-                        }
-                        else
+                        int cell = board[index + i * step];
+                        if (cell == value)
+                            num++;
+                        else if (cell != 0)
                             ok = false;
                     }
                     if (ok && num == 4)
                     {
                         for (int i = 0; i < 5; ++i)
                         {
-                            new_x = row + i * dx[direction];
-                            new_y = col + i * dy[direction];
-                            if (!board[new_x][new_y])
-                                return Point(new_x, new_y);
+                            // whether the completed line wins (blocked ends, overlines) is up to the rule
+                            if (!board[index + i * step] && board.makesFive<Rule>(index + i * step, value))
+                                return Point(row + i * dx[direction], col + i * dy[direction]);
                         }
                     }
                 }
@@ -244,171 +315,152 @@ private:
         }
     }
 
+    // score the cells from..to (inclusive) of one line walked in direction,
+    // the empty cell extra (-1 for none) is read as a stone of extra_color.
+    // The stones after an empty cell are read from the run cache in one step
+    void scoreLine(int from, int to, int direction, int in_color, int next_color, int &result, int extra = -1, int extra_color = 0)
+    {
+        int step = dstep[direction];
+        int consecutive = 0, block = 2;
+        for (int index = from; index != to + step; index += step)
+        {
+            int value = index == extra ? extra_color : board[index];
+            loopProcess(value, in_color, next_color, consecutive, block, result);
+            if (value != 0)
+                continue;
+            const Run &run = board.run(index, direction);
+            if (run.length == 0 || run.length > (to - index) / step)
+                continue;
+            // same as feeding its stones to loopProcess right after the empty cell
+            if (run.color == in_color)
+                consecutive = run.length;
+            else
+                block = 2;
+            index += run.length * step;
+        }
+        loopProcess(-in_color, in_color, next_color, consecutive, block, result);
+    }
+
     // get score for the in_color in the board whose turn is next_color
+    // only lines crossing the bounding box are scanned, each from one cell before
+    // its first stone to one cell after its last, the rest of the line is empty
     int getScore(int in_color, int next_color)
     {
         int rowScore = 0, colScore = 0, diagonalScore = 0;
+        if (board.stones() == 0)
+            return 0;
+        const BoundingBox &box = board.bounds();
         // row
-        int consecutive = 0, block = 2;
-        for (int row = 0; row < HEIGHT; ++row)
+        int first_col = std::max(0, box.left - 1), last_col = std::min(WIDTH - 1, box.right + 1);
+        for (int row = box.top; row <= box.bottom; ++row)
         {
-            for (int col = 0; col < WIDTH; ++col)
-            {
-                loopProcess(board[row][col], in_color, next_color, consecutive, block, rowScore);
-            }
-            loopProcess(-in_color, in_color, next_color, consecutive, block, rowScore);
-            consecutive = 0;
-            block = 2;
+            scoreLine(toIndex(row, first_col), toIndex(row, last_col), 3, in_color, next_color, rowScore);
         }
 
         // col
-        for (int col = 0; col < WIDTH; ++col)
+        int first_row = std::max(0, box.top - 1), last_row = std::min(HEIGHT - 1, box.bottom + 1);
+        for (int col = box.left; col <= box.right; ++col)
         {
-            for (int row = 0; row < HEIGHT; ++row)
-            {
-                loopProcess(board[row][col], in_color, next_color, consecutive, block, colScore);
-            }
-
-            loopProcess(-in_color, in_color, next_color, consecutive, block, colScore);
-            consecutive = 0;
-            block = 2;
+            scoreLine(toIndex(first_row, col), toIndex(last_row, col), 1, in_color, next_color, colScore);
         }
 
-        // diagonal
-        for (int col = 0; col < WIDTH; ++col)
+        // diagonal, cells (row, row + shift)
+        for (int shift = box.left - box.bottom; shift <= box.right - box.top; ++shift)
         {
-            int start_x = 0, start_y = col;
-            while (inBoard(start_x, start_y))
-            {
-                loopProcess(board[start_x][start_y], in_color, next_color, consecutive, block, diagonalScore);
-                start_x++;
-                start_y++;
-            }
-            loopProcess(-in_color, in_color, next_color, consecutive, block, diagonalScore);
-            consecutive = 0;
-            block = 2;
-        }
-
-        for (int row = 1; row < HEIGHT; ++row)
-        {
-            int start_x = row, start_y = 0;
-            while (inBoard(start_x, start_y))
-            {
-                loopProcess(board[start_x][start_y], in_color, next_color, consecutive, block, diagonalScore);
-                start_x++;
-                start_y++;
-            }
-            loopProcess(-in_color, in_color, next_color, consecutive, block, diagonalScore);
-            consecutive = 0;
-            block = 2;
-        }
-
-        for (int col = 0; col < WIDTH; ++col)
-        {
-            int start_x = 0, start_y = col;
-            while (inBoard(start_x, start_y))
-            {
-                loopProcess(board[start_x][start_y], in_color, next_color, consecutive, block, diagonalScore);
-                start_x++;
-                start_y--;
-            }
-            loopProcess(-in_color, in_color, next_color, consecutive, block, diagonalScore);
-            consecutive = 0;
-            block = 2;
+            int first = std::max(std::max(box.top, box.left - shift) - 1, std::max(0, -shift));
+            int last = std::min(std::min(box.bottom, box.right - shift) + 1, std::min(HEIGHT - 1, WIDTH - 1 - shift));
+            scoreLine(toIndex(first, first + shift), toIndex(last, last + shift), 2, in_color, next_color, diagonalScore);
         }
 
-        for (int row = 1; row < HEIGHT; ++row)
+        // anti diagonal, cells (row, sum - row)
+        for (int sum = box.top + box.left; sum <= box.bottom + box.right; ++sum)
         {
-            int start_x = row, start_y = WIDTH - 1;
-            while (inBoard(start_x, start_y))
-            {
-                loopProcess(board[start_x][start_y], in_color, next_color, consecutive, block, diagonalScore);
-                start_x++;
-                start_y--;
-            }
-            loopProcess(-in_color, in_color, next_color, consecutive, block, diagonalScore);
-            consecutive = 0;
-            block = 2;
+            int first = std::max(std::max(box.top, sum - box.right) - 1, std::max(0, sum - (WIDTH - 1)));
+            int last = std::min(std::min(box.bottom, sum - box.left) + 1, std::min(HEIGHT - 1, sum));
+            scoreLine(toIndex(first, sum - first), toIndex(last, sum - last), 0, in_color, next_color, diagonalScore);
         }
         return rowScore + colScore + diagonalScore;
     }
 
-    // board evaluation function
+    // board evaluation function, the network logit is mapped to the same
+    // white / black ratio scale as the pattern scores
     double getBoardEvaluation(int next_color)
     {
+        if (board.getNetwork())
+            return std::exp(board.getNetwork()->evaluate(board.accumulator(), next_color));
         int white = getScore(1, next_color);
         int black = getScore(-1, next_color);
         return 1.0 * white / black;
     }
 
-    // check isGameOver
-    bool isGameOver()
+    // evaluation of a finished game (isGameOver). The pattern scores see the
+    // winning line themselves; the network was never trained on finished games,
+    // so with it a win is worth winScore to its side and a full board is even
+    double gameOverEvaluation(int next_color)
     {
-        // check if the board is fulfilled or not
-        bool isFull = true;
-        for (int row = 0; row < HEIGHT; ++row)
+        if (!board.getNetwork())
+            return getBoardEvaluation(next_color);
+        int winner = board.winner<Rule>();
+        if (winner == 0)
+            return 1;
+        return winner == 1 ? winScore : 1.0 / winScore;
+    }
+
+    // getBoardEvaluation of every child of the node, in_color to move, without
+    // placing them. A stone only changes the runs next to it, so each child adds
+    // to the scores of the node the change of the four line segments from the
+    // cell past those runs on one side to the cell past them on the other.
+    // Occupied children score 0. The pattern scores only, not the network
+    void evaluateChildren(const std::vector<Point> &listChild, int in_color, std::vector<double> &scores)
+    {
+        int next_color = -in_color;
+        int white = getScore(1, next_color), black = getScore(-1, next_color);
+        scores.assign(listChild.size(), 0);
+        for (size_t i = 0; i < listChild.size(); ++i)
         {
-            for (int col = 0; col < WIDTH; ++col)
+            int index = toIndex(listChild[i].x, listChild[i].y);
+            if (board[index] != 0)
+                continue;
+            int child_white = white, child_black = black;
+            for (int axis = 0; axis < 4; ++axis)
             {
-                if (board[row][col] == 0)
-                    isFull = false;
+                int step = axis_step[axis], direction = axis_dir[axis];
+                int from = index - (board.run(index, opposite[direction]).length + 1) * step;
+                int to = index + (board.run(index, direction).length + 1) * step;
+                int before = 0, after = 0;
+                scoreLine(from, to, direction, 1, next_color, before);
+                scoreLine(from, to, direction, 1, next_color, after, index, in_color);
+                child_white += after - before;
+                before = after = 0;
+                scoreLine(from, to, direction, -1, next_color, before);
+                scoreLine(from, to, direction, -1, next_color, after, index, in_color);
+                child_black += after - before;
             }
+            scores[i] = 1.0 * child_white / child_black;
         }
-        if (isFull)
+    }
+
+    // check isGameOver
+    bool isGameOver()
+    {
+        // check if the board is fulfilled or not
+        if (board.stones() == HEIGHT * WIDTH)
             return true;
-        // check if a 5 consecutive same color exists or not
-        for (int x = 0; x < HEIGHT; ++x)
-        {
-            for (int y = 0; y < WIDTH; ++y)
-            {
-                int color = board[x][y];
-                if (color == 0)
-                    continue;
-                for (int i = 0; i < 8; ++i)
-                {
-                    bool ok = true;
-                    for (int j = 0; j <= 4; ++j)
-                    {
-                        int next_x = x + dx[i] * j, next_y = y + dy[i] * j;
-                        if (board[next_x][next_y] == color)
-                        {
-                            ok = false;
-                            break;
-                        }
-                    }
-                    if (ok)
-                        return true;
-                }
-            }
-        }
-        return false;
+        // check if a winning line of either color exists or not
+        return board.winner<Rule>() != 0;
     }
 
-    // calculate candidate score for a Point in the board
+    // calculate candidate score for a Point in the board, read from the run cache
     std::pair<int, int> getCandidateScore(int row, int col)
     {
         std::pair<int, int> ans = std::make_pair(0, 0);
+        int index = toIndex(row, col);
         for (int i = 0; i < 8; ++i)
         {
-            int start_x = row + dx[i], start_y = col + dy[i];
-            if (!inBoard(start_x, start_y) || board[start_x][start_y] == 0)
+            const Run &run = board.run(index, i);
+            if (run.length == 0)
                 continue;
-            int color = board[start_x][start_y];
-            int num = 0;
-            while (true)
-            {
-                int next_x = start_x + num * dx[i];
-                int next_y = start_y + num * dy[i];
-                if (inBoard(next_x, next_y) && board[next_x][next_y] == color)
-                {
-                    num++;
-                }
-                else
-                {
-                    break;
-                }
-            }
-            ans = std::max(ans, std::make_pair(num, (int)(board[row][col] == color)));
+            ans = std::max(ans, std::make_pair((int)run.length, (int)(board[index] == run.color)));
         }
         return ans;
     }
@@ -419,17 +471,20 @@ private:
         std::vector<Candidate> listCandidate;
         listCandidate.clear();
 
-        for (int new_x = 0; new_x < HEIGHT; ++new_x)
+        // every candidate touches a stone, so it is inside the box grown by one cell
+        const BoundingBox &box = board.bounds();
+        int last_x = std::min(HEIGHT - 1, box.bottom + 1), last_y = std::min(WIDTH - 1, box.right + 1);
+        for (int new_x = std::max(0, box.top - 1); new_x <= last_x; ++new_x)
         {
-            for (int new_y = 0; new_y < WIDTH; ++new_y)
+            for (int new_y = std::max(0, box.left - 1); new_y <= last_y; ++new_y)
             {
-                if (board[new_x][new_y] != 0)
+                int index = toIndex(new_x, new_y);
+                if (board[index] != 0)
                     continue;
                 bool isCandidate = false;
                 for (int i = 0; i < 8; ++i)
                 {
-                    int x = new_x + dx[i], y = new_y + dy[i];
-                    if (inBoard(x, y) && board[x][y] != 0)
+                    if (board.run(index, i).length > 0)
                     {
                         isCandidate = true;
                     }
@@ -454,25 +509,63 @@ private:
         return ans;
     }
 
+    // set aborted when the search must stop, the clock is only read every 128 nodes
+    // unless read_clock
+    bool checkAbort(bool read_clock = false)
+    {
+        if (aborted)
+            return true;
+        if (yield_hook && nodes >= next_yield)
+        {
+            next_yield = nodes + yield_every;
+            yield_hook(yield_arg);
+        }
+        if (stop_flag.load(std::memory_order_relaxed) || (node_limit && nodes >= node_limit))
+            aborted = true;
+        else if (has_deadline && (read_clock || (nodes & 127) == 0) && std::chrono::steady_clock::now() >= deadline)
+            aborted = true;
+        return aborted;
+    }
+
     // alpha-beta pruning recursive function
     double alphaBetaPruning(int depth, double alpha, double beta, bool isMax, int in_color)
     {
-        if (depth == 0 || isGameOver())
+        nodes++;
+        if (checkAbort())
+            return 0;
+        TTEntry entry;
+        if (tt.probe(board.key(in_color), entry) && entry.depth == PROVEN_DEPTH)
+            return entry.score;
+        if (isGameOver())
+        {
+            return gameOverEvaluation(in_color);
+        }
+        if (depth == 0)
         {
-            return getBoardEvaluation(in_color);
+            if (quiescence == QUIESCENCE_OFF)
+                return getBoardEvaluation(in_color);
+            return quiescenceSearch(alpha, beta, isMax, in_color, 0);
         }
+        if (opponent_model == OPPONENT_BASELINE && in_color == -color)
+            return expectedReply(depth, isMax, in_color);
         std::vector<Point> listChild = getCandidate();
+        if (depth == 1 && !board.getNetwork())
+            return frontierSearch(listChild, alpha, beta, isMax, in_color);
         // isMax
         if (isMax)
         {
             double maxEval = -INF;
             for (auto child : listChild)
             {
-                if (board[child.x][child.y] != 0)
+                int index = toIndex(child.x, child.y);
+                if (board[index] != 0)
                     continue;
-                board[child.x][child.y] = in_color;
+                BoundingBox saved = board.bounds();
+                board.place(index, in_color);
                 double eval = alphaBetaPruning(depth - 1, alpha, beta, false, -in_color);
-                board[child.x][child.y] = 0;
+                board.remove(index, saved);
+                if (aborted)
+                    return 0;
                 maxEval = std::max(maxEval, eval);
                 if (eval >= beta)
                     return eval;
@@ -484,11 +577,15 @@ private:
         double minEval = INF;
         for (auto child : listChild)
         {
-            if (board[child.x][child.y] != 0)
+            int index = toIndex(child.x, child.y);
+            if (board[index] != 0)
                 continue;
-            board[child.x][child.y] = in_color;
+            BoundingBox saved = board.bounds();
+            board.place(index, in_color);
             double eval = alphaBetaPruning(depth - 1, alpha, beta, true, -in_color);
-            board[child.x][child.y] = 0;
+            board.remove(index, saved);
+            if (aborted)
+                return 0;
             minEval = std::min(minEval, eval);
             if (eval <= alpha)
                 return eval;
@@ -497,19 +594,194 @@ private:
         return minEval;
     }
 
+    // alphaBetaPruning of a depth 1 node, its children are scored together by
+    // evaluateChildren. Without quiescence those scores are the leaf values and
+    // the children keep the candidate order; with it they are the stand-pat of
+    // each child's quiescence search and the best scored children go first
+    double frontierSearch(const std::vector<Point> &listChild, double alpha, double beta, bool isMax, int in_color)
+    {
+        std::vector<double> scores;
+        evaluateChildren(listChild, in_color, scores);
+        std::vector<int> order(listChild.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = (int)i;
+        if (quiescence != QUIESCENCE_OFF)
+            std::stable_sort(order.begin(), order.end(), [&scores, isMax](int a, int b)
+                             { return isMax ? scores[a] > scores[b] : scores[a] < scores[b]; });
+        double best = isMax ? -INF : INF;
+        for (int i : order)
+        {
+            int index = toIndex(listChild[i].x, listChild[i].y);
+            if (board[index] != 0)
+                continue;
+            // the leaf alphaBetaPruning would have visited
+            nodes++;
+            if (checkAbort())
+                return 0;
+            double eval = scores[i];
+            TTEntry entry;
+            if (tt.probe(board.key(-in_color) ^ zobrist.key(index, in_color), entry) && entry.depth == PROVEN_DEPTH)
+                eval = entry.score;
+            else if (quiescence != QUIESCENCE_OFF && !board.makesFive<Rule>(index, in_color) && board.stones() + 1 < HEIGHT * WIDTH)
+            {
+                BoundingBox saved = board.bounds();
+                board.place(index, in_color);
+                eval = quiescenceSearch(alpha, beta, !isMax, -in_color, 0, scores[i]);
+                board.remove(index, saved);
+                if (aborted)
+                    return 0;
+            }
+            if (isMax)
+            {
+                best = std::max(best, eval);
+                if (eval >= beta)
+                    return eval;
+                alpha = std::max(alpha, eval);
+            }
+            else
+            {
+                best = std::min(best, eval);
+                if (eval <= alpha)
+                    return eval;
+                beta = std::min(beta, eval);
+            }
+        }
+        return best;
+    }
+
+    // average over the replies player_baseline can choose, weighted by their probability.
+    // Every child is searched with a full window since an average can't be cut off
+    double expectedReply(int depth, bool isMax, int in_color)
+    {
+        std::vector<std::pair<int, double>> policy;
+        baseline_policy(board.data(), in_color, policy);
+        if (policy.empty())
+            // the baseline can't produce a legal move and loses
+            return color == 1 ? provenScore : -provenScore;
+        double expected = 0;
+        for (auto &reply : policy)
+        {
+            BoundingBox saved = board.bounds();
+            board.place(reply.first, in_color);
+            double eval = alphaBetaPruning(depth - 1, -INF, INF, !isMax, -in_color);
+            board.remove(reply.first, saved);
+            if (aborted)
+                return 0;
+            expected += reply.second * eval;
+        }
+        return expected;
+    }
+
+    // play index, evaluate the child with the next search function, take it back
+    double quiescenceChild(int index, double alpha, double beta, bool isMax, int in_color, int ply)
+    {
+        BoundingBox saved = board.bounds();
+        board.place(index, in_color);
+        double eval = quiescenceSearch(alpha, beta, !isMax, -in_color, ply + 1);
+        board.remove(index, saved);
+        return eval;
+    }
+
+    // forcing moves only, until the position is quiet: a five ends it, a four must
+    // be answered, otherwise the side to move may stand pat or play a four
+    // (and an open three in QUIESCENCE_THREES mode).
+    // knownStandPat is the evaluation of the position when the caller has it, NAN otherwise
+    double quiescenceSearch(double alpha, double beta, bool isMax, int in_color, int ply, double knownStandPat = NAN)
+    {
+        nodes++;
+        qnodes++;
+        if (checkAbort())
+            return 0;
+        std::vector<int> moves;
+        board.fiveSquares<Rule>(in_color, moves);
+        if (!moves.empty())
+        {
+            BoundingBox saved = board.bounds();
+            board.place(moves[0], in_color);
+            double eval = gameOverEvaluation(-in_color);
+            board.remove(moves[0], saved);
+            return eval;
+        }
+        bool limit = ply >= QUIESCENCE_DEPTH || qnodes >= QUIESCENCE_NODES;
+        board.fiveSquares<Rule>(-in_color, moves);
+        if (!moves.empty())
+        {
+            // no standing pat against a four, the block is forced
+            if (limit)
+                return std::isnan(knownStandPat) ? getBoardEvaluation(in_color) : knownStandPat;
+            return quiescenceChild(moves[0], alpha, beta, isMax, in_color, ply);
+        }
+
+        double standPat = std::isnan(knownStandPat) ? getBoardEvaluation(in_color) : knownStandPat;
+        if (limit)
+            return standPat;
+        if (isMax)
+        {
+            if (standPat >= beta)
+                return standPat;
+            alpha = std::max(alpha, standPat);
+        }
+        else
+        {
+            if (standPat <= alpha)
+                return standPat;
+            beta = std::min(beta, standPat);
+        }
+
+        board.fourMoves<Rule>(in_color, moves);
+        if (quiescence == QUIESCENCE_THREES)
+        {
+            const BoundingBox &box = board.bounds();
+            int last_x = std::min(HEIGHT - 1, box.bottom + 2), last_y = std::min(WIDTH - 1, box.right + 2);
+            for (int row = std::max(0, box.top - 2); row <= last_x; ++row)
+            {
+                for (int col = std::max(0, box.left - 2); col <= last_y; ++col)
+                {
+                    int index = toIndex(row, col);
+                    if (board[index] == 0 && !board.makesFour<Rule>(index, in_color) && board.makesOpenThree(index, in_color))
+                        moves.push_back(index);
+                }
+            }
+        }
+
+        double best = standPat;
+        for (int index : moves)
+        {
+            double eval = quiescenceChild(index, alpha, beta, isMax, in_color, ply);
+            if (aborted)
+                return 0;
+            if (isMax)
+            {
+                best = std::max(best, eval);
+                if (eval >= beta)
+                    return eval;
+                alpha = std::max(alpha, eval);
+            }
+            else
+            {
+                best = std::min(best, eval);
+                if (eval <= alpha)
+                    return eval;
+                beta = std::min(beta, eval);
+            }
+        }
+        return best;
+    }
+
     // early move when num_occupied < 4
     Point earlyMove()
     {
+        const BoundingBox &box = board.bounds();
         if (num_occupied == 0)
             return Point(HEIGHT / 2, WIDTH / 2);
         if (num_occupied == 1)
         {
             // find the occupied point
-            for (int i = 0; i < HEIGHT; ++i)
+            for (int i = box.top; i <= box.bottom; ++i)
             {
-                for (int j = 0; j < WIDTH; ++j)
+                for (int j = box.left; j <= box.right; ++j)
                 {
-                    if (board[i][j] != 0)
+                    if (board[toIndex(i, j)] != 0)
                     // set the des point based on the occupied point
                     {
                         int des_x = i, des_y = j;
@@ -531,17 +803,17 @@ private:
         if (num_occupied == 2)
         {
             int f_x = 0, f_y = 0, s_x = 0, s_y = 0;
-            for (int i = 0; i < HEIGHT; ++i)
+            for (int i = box.top; i <= box.bottom; ++i)
             {
-                for (int j = 0; j < WIDTH; ++j)
+                for (int j = box.left; j <= box.right; ++j)
                 {
                     // find our first point
-                    if (board[i][j] == color)
+                    if (board[toIndex(i, j)] == color)
                     {
                         f_x = i;
                         f_y = j;
                     }
-                    else if (board[i][j] != 0)
+                    else if (board[toIndex(i, j)] != 0)
                     {
                         s_x = i;
                         s_y = j;
@@ -569,120 +841,418 @@ private:
         if (num_occupied == 3)
         {
             // find our point
-            for (int row = 0; row < HEIGHT; ++row)
+            for (int row = box.top; row <= box.bottom; ++row)
             {
-                for (int col = 0; col < WIDTH; ++col)
+                for (int col = box.left; col <= box.right; ++col)
                 {
-                    if (board[row][col] == color)
+                    if (board[toIndex(row, col)] == color)
                     {
                         for (int k = 0; k < 8; ++k)
                         {
-                            int new_x = row + dx[k], new_y = col + dy[k];
-                            if (board[new_x][new_y] != 0)
+                            // a border cell is not empty, so this never leaves the board
+                            if (board[toIndex(row, col) + dstep[k]] != 0)
                                 continue;
-                            return Point(new_x, new_y);
+                            return Point(row + dx[k], col + dy[k]);
                         }
                     }
                 }
             }
         }
+        return Point(-1, -1);
     }
 
-public:
-    // initialize the size of the board
-    Gomoku()
+    // a position worth more time: a five or a four of either side can be played
+    bool isCritical()
     {
-        board.resize(HEIGHT);
-        for (int i = 0; i < HEIGHT; ++i)
+        if (hasFiveThreat())
+            return true;
+        std::vector<int> fours;
+        board.fourMoves<Rule>(color, fours);
+        if (!fours.empty())
+            return true;
+        board.fourMoves<Rule>(-color, fours);
+        return !fours.empty();
+    }
+
+    // a root score that deeper iterations won't change: proven, or one side
+    // already owns a winning pattern and the other has nothing close
+    bool isDecided(double score)
+    {
+        return std::fabs(score) >= provenScore || score >= winGurantee || (score >= 0 && score * winGurantee <= 1);
+    }
+
+    struct SolverProgress
+    {
+        GomokuEngine *engine;
+        long long start_nodes;
+    };
+
+    // abort check of the solver: its positions count as nodes, so the node limit,
+    // the deadline, stop() and the yield hook all apply while it runs
+    static bool solverAbort(void *arg, long long created)
+    {
+        SolverProgress *progress = (SolverProgress *)arg;
+        progress->engine->nodes = progress->start_nodes + created;
+        return progress->engine->checkAbort(true);
+    }
+
+    // look up or prove a continuous-four win for color, return (-1, -1) when there is none
+    Point provenMove(double &score)
+    {
+        score = (color == 1 ? provenScore : -provenScore);
+        TTEntry entry;
+        if (tt.probe(board.key(color), entry) && entry.depth == PROVEN_DEPTH && entry.move >= 0)
+            return Point(entry.move / WIDTH, entry.move % WIDTH);
+        if (!use_solver)
+            return Point(-1, -1);
+        std::vector<int> fours;
+        board.fourMoves<Rule>(color, fours);
+        if (fours.empty())
+            return Point(-1, -1);
+
+        ProofNumberSolver<Rule> solver;
+        int move;
+        SolverProgress progress;
+        progress.engine = this;
+        progress.start_nodes = nodes;
+        int result = solver.solve(board, color, move, solverAbort, &progress);
+        nodes = progress.start_nodes + solver.nodeCount();
+        if (result != SOLVER_WIN)
+            return Point(-1, -1);
+        // cache every proven attacker position, later moves of the same attack hit them
+        std::vector<std::pair<unsigned long long, int>> proven;
+        solver.proven(proven);
+        for (auto &item : proven)
         {
-            board[i].resize(WIDTH);
+            int cell = indexRow(item.second) * WIDTH + indexCol(item.second);
+            tt.store(item.first, PROVEN_DEPTH, BOUND_EXACT, score, cell);
         }
+        return Point(indexRow(move), indexCol(move));
     }
 
-    // nextMove API
-    Point nextMove(int in_board[][WIDTH], int in_color)
+    // root result of the persistent cache when it was searched at least min_depth deep
+    Point cachedMove(int min_depth, SearchInfo &result)
     {
-        num_occupied = 0;
-        for (int i = 0; i < HEIGHT; ++i)
+        CacheEntry entry;
+        if (!cache || !cache->probe(board, color, entry) || entry.bound != BOUND_EXACT || entry.move < 0 ||
+            entry.depth < min_depth || board[toIndex(entry.move / WIDTH, entry.move % WIDTH)] != 0)
+            return Point(-1, -1);
+        // storing it again keeps a used entry from aging out
+        cache->store(board, color, entry);
+        result.score = entry.score;
+        result.depth = entry.depth == CACHE_PROVEN_DEPTH ? 0 : entry.depth;
+        return Point(entry.move / WIDTH, entry.move % WIDTH);
+    }
+
+    void storeCache(int in_depth, const SearchInfo &result)
+    {
+        if (!cache || result.best.x == -1)
+            return;
+        CacheEntry entry;
+        entry.depth = in_depth;
+        entry.bound = BOUND_EXACT;
+        entry.score = result.score;
+        entry.move = result.best.x * WIDTH + result.best.y;
+        cache->store(board, color, entry);
+    }
+
+    void setInfo(const SearchInfo &in_info)
+    {
+        std::lock_guard<std::mutex> lock(info_mutex);
+        info = in_info;
+    }
+
+    // search every root child at the given depth, return the best one and its score
+    // when scores is given every child is searched with a full window and recorded
+    Point searchRoot(const std::vector<Point> &listChild, int in_depth, double &result, std::vector<RootMove> *scores)
+    {
+        result = (num_occupied % 2 == 0 ? -INF : INF);
+        double alpha = -INF, beta = INF;
+        int best_x = -1, best_y = -1;
+        // std::cout << "-----------------------------" << std::endl;
+        for (auto child : listChild)
         {
-            for (int j = 0; j < WIDTH; ++j)
+            int index = toIndex(child.x, child.y);
+            if (board[index] != 0)
+                continue;
+            BoundingBox saved = board.bounds();
+            board.place(index, color);
+            double eval = 0;
+            if (num_occupied % 2 == 0)
+            {
+                eval = alphaBetaPruning(in_depth - 1, alpha, beta, false, -color);
+            }
+            else
+            {
+                eval = alphaBetaPruning(in_depth - 1, alpha, beta, true, -color);
+            }
+            board.remove(index, saved);
+            if (aborted)
+                break;
+            if (num_occupied % 2 == 0)
+            {
+                if (result < eval)
+                {
+                    result = eval;
+                    best_x = child.x;
+                    best_y = child.y;
+                }
+            }
+            else
             {
-                board[i][j] = in_board[i][j];
-                if (board[i][j] != 0)
+                if (result > eval)
                 {
-                    num_occupied++;
+                    result = eval;
+                    best_x = child.x;
+                    best_y = child.y;
                 }
             }
+            // std::cout << child.x << " " << child.y << " " << eval << std::endl;
+            if (scores)
+            {
+                RootMove move;
+                move.point = child;
+                move.score = eval;
+                scores->push_back(move);
+                continue;
+            }
+            if (num_occupied % 2 == 0)
+            {
+                alpha = std::max(alpha, eval);
+            }
+            else
+            {
+                beta = std::min(beta, eval);
+            }
+        }
+        // std::cout << "--------------------------" << std::endl;
+        return Point(best_x, best_y);
+    }
+
+public:
+    // RULE_* id of the rule the engine plays, as stored in game records
+    static constexpr int rule_id = Rule::id;
+
+    // initialize the size of the board
+    GomokuEngine()
+    {
+        depth = DEPTH;
+        nodes = 0;
+        stop_flag = false;
+        aborted = false;
+        node_limit = 0;
+        has_deadline = false;
+        use_solver = true;
+        quiescence = QUIESCENCE_FOURS;
+        opponent_model = OPPONENT_MINIMAX;
+        deterministic = false;
+        qnodes = 0;
+        cache = NULL;
+        yield_hook = NULL;
+        yield_arg = NULL;
+        yield_every = 0;
+        next_yield = 0;
+    }
+
+    // nextMove API
+    Point nextMove(int in_board[][WIDTH], int in_color)
+    {
+        SearchLimits limits;
+        limits.depth = depth;
+        clearStop();
+        return search(in_board, in_color, limits).best;
+    }
+
+    // search with a depth / node / time budget, the best move of the deepest
+    // completed iteration is returned; stop() aborts it from another thread.
+    // When moves is given, every root move gets an exact score and moves is
+    // filled best first (slower, since the root window is never narrowed).
+    SearchInfo search(int in_board[][WIDTH], int in_color, const SearchLimits &limits, std::vector<RootMove> *moves = NULL)
+    {
+        long long start_nodes = nodes;
+        aborted = false;
+        long long node_budget = limits.nodes;
+        if (deterministic)
+        {
+            // the time limit becomes a node budget, proven results of earlier searches are dropped
+            if (limits.time_ms > 0 && (node_budget == 0 || limits.time_ms * NODES_PER_MS < node_budget))
+                node_budget = limits.time_ms * NODES_PER_MS;
+            tt.clear();
         }
+        board.load(in_board);
+        num_occupied = board.stones();
         color = in_color;
+
+        long long time_ms = limits.time_ms;
+        if (limits.clock)
+        {
+            limits.clock->startMove(isCritical());
+            if (time_ms == 0 || limits.clock->hardBudget() < time_ms)
+                time_ms = limits.clock->hardBudget();
+            // the clock only ends iterations early by its hard budget here, turned into nodes
+            if (deterministic && (node_budget == 0 || time_ms * NODES_PER_MS < node_budget))
+                node_budget = time_ms * NODES_PER_MS;
+        }
+        node_limit = node_budget ? nodes + node_budget : 0;
+        has_deadline = time_ms > 0 && !deterministic;
+        qnodes = 0;
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_ms);
+        setInfo(SearchInfo());
+
+        SearchInfo result;
+        if (moves)
+            moves->clear();
         if (num_occupied < 4)
-            return earlyMove();
-        else
+            result.best = earlyMove();
+        else if (!isGameOver())
         {
-            if (isGameOver())
-            {
-                return Point(-1, -1);
-            }
-            Point finish = finishMove();
-            if (finish.x != -1 && finish.y != -1)
+            result.best = finishMove();
+            if (result.best.x == -1 || result.best.y == -1)
             {
-                return finish;
+                if (!deterministic)
+                    result.best = cachedMove(limits.depth, result);
+                if (result.best.x == -1)
+                {
+                    result.best = provenMove(result.score);
+                    storeCache(CACHE_PROVEN_DEPTH, result);
+                }
             }
-            else
+            if (result.best.x == -1 || result.best.y == -1)
             {
+                result.score = 0;
                 std::vector<Point> listChild = getCandidate();
-                double result = (num_occupied % 2 == 0 ? -INF : INF);
-                double alpha = -INF, beta = INF;
-                int best_x = -1, best_y = -1;
-                // std::cout << "-----------------------------" << std::endl;
-                for (auto child : listChild)
+                // a legal move even when the first iteration is aborted before its first child
+                if (!listChild.empty())
+                    result.best = listChild[0];
+                std::vector<RootMove> scores;
+                for (int iteration = 1; iteration <= limits.depth; ++iteration)
                 {
-                    if (board[child.x][child.y] != 0)
-                        continue;
-                    board[child.x][child.y] = color;
-                    double eval = 0;
-                    if (num_occupied % 2 == 0)
+                    double score;
+                    scores.clear();
+                    Point best = searchRoot(listChild, iteration, score, moves ? &scores : NULL);
+                    // an aborted iteration is only used when nothing was completed before
+                    if (aborted && result.depth > 0)
+                        break;
+                    if (best.x != -1)
                     {
-                        eval = alphaBetaPruning(DEPTH - 1, alpha, beta, false, -color);
+                        result.best = best;
+                        result.score = score;
                     }
-                    else
+                    if (moves)
                     {
-                        eval = alphaBetaPruning(DEPTH - 1, alpha, beta, true, -color);
-                    }
-                    board[child.x][child.y] = 0;
-                    if (num_occupied % 2 == 0)
-                    {
-                        if (result < eval)
-                        {
-                            result = eval;
-                            best_x = child.x;
-                            best_y = child.y;
-                        }
-                    }
-                    else
-                    {
-                        if (result > eval)
-                        {
-                            result = eval;
-                            best_x = child.x;
-                            best_y = child.y;
-                        }
-                    }
-                    // std::cout << child.x << " " << child.y << " " << eval << std::endl;
-                    if (num_occupied % 2 == 0)
-                    {
-                        alpha = std::max(alpha, eval);
-                    }
-                    else
-                    {
-                        beta = std::min(beta, eval);
+                        bool maximize = num_occupied % 2 == 0;
+                        std::stable_sort(scores.begin(), scores.end(), [maximize](const RootMove &a, const RootMove &b)
+                                         { return maximize ? a.score > b.score : a.score < b.score; });
+                        *moves = scores;
                     }
+                    if (aborted)
+                        break;
+                    result.depth = iteration;
+                    result.nodes = nodes - start_nodes;
+                    setInfo(result);
+                    if (limits.clock && !deterministic &&
+                        !limits.clock->nextIteration(result.best, listChild.size() == 1, isDecided(result.score)))
+                        break;
                 }
-                // std::cout << "--------------------------" << std::endl;
-                return Point(best_x, best_y);
+                if (result.depth > 0)
+                    storeCache(result.depth, result);
             }
-            return Point(-1, -1);
         }
+        // early and forced moves are the only move worth reporting
+        if (moves && moves->empty() && result.best.x != -1)
+        {
+            RootMove move;
+            move.point = result.best;
+            move.score = result.score;
+            moves->push_back(move);
+        }
+        result.nodes = nodes - start_nodes;
+        result.finished = true;
+        setInfo(result);
+        return result;
+    }
+
+    // request the running search to stop, safe to call from another thread
+    void stop()
+    {
+        stop_flag = true;
+    }
+
+    // allow searching again after stop()
+    void clearStop()
+    {
+        stop_flag = false;
+    }
+
+    // snapshot of the running search, safe to call from another thread
+    SearchInfo currentInfo()
+    {
+        std::lock_guard<std::mutex> lock(info_mutex);
+        return info;
+    }
+
+    // set the search depth used by nextMove
+    void setDepth(int in_depth)
+    {
+        depth = in_depth;
+    }
+
+    // enable or disable the proof-number solver
+    void setSolver(bool enabled)
+    {
+        use_solver = enabled;
+    }
+
+    // evaluate with a network instead of the pattern scores, NULL switches back
+    void setNetwork(const Network *network)
+    {
+        board.setNetwork(network);
+    }
+
+    // call hook(arg) every every nodes from inside the search, NULL removes it.
+    // The hook may switch to another context and resume the search later
+    void setYield(void (*hook)(void *), void *arg, long long every)
+    {
+        yield_hook = hook;
+        yield_arg = arg;
+        yield_every = every > 0 ? every : 1;
+        next_yield = nodes + yield_every;
+    }
+
+    // search the replies of the other side as OPPONENT_MINIMAX or OPPONENT_BASELINE
+    void setOpponentModel(int model)
+    {
+        opponent_model = model;
+    }
+
+    // identical inputs give identical moves and node counts: time limits are
+    // converted into NODES_PER_MS nodes per millisecond, and neither the proven
+    // results of earlier searches nor the persistent cache are read.
+    // Only stop() from another thread can still change a result
+    void setDeterministic(bool enabled)
+    {
+        deterministic = enabled;
+    }
+
+    // share root results through a persistent cache, NULL disables it.
+    // The cache must outlive the searches using it; one opened for another
+    // rule is refused (false) and leaves the engine without a cache
+    bool setCache(PositionCache *in_cache)
+    {
+        cache = in_cache && in_cache->rule() == Rule::id ? in_cache : NULL;
+        return cache == in_cache;
+    }
+
+    // choose the quiescence mode, QUIESCENCE_OFF evaluates the horizon statically
+    void setQuiescence(int mode)
+    {
+        quiescence = mode;
+    }
+
+    // number of searched nodes since construction
+    long long getNodeCount()
+    {
+        return nodes;
     }
 
     // just for testing (test.cpp file)
@@ -696,13 +1266,46 @@ public:
     // set board values
     void initBoard(int in_board[][WIDTH])
     {
-        for (int i = 0; i < HEIGHT; ++i)
+        board.load(in_board);
+        color = -1;
+    }
+
+    // scores, candidates and terminal flag of the board set by initBoard (differential_test.cpp)
+    int scoreOf(int in_color, int next_color)
+    {
+        return getScore(in_color, next_color);
+    }
+
+    std::vector<Point> candidates()
+    {
+        return getCandidate();
+    }
+
+    bool gameOver()
+    {
+        return isGameOver();
+    }
+
+    // number of move sequences of length in_depth over getCandidate moves from the
+    // board set by initBoard, a finished game counts as one
+    long long perft(int in_depth, int in_color)
+    {
+        if (in_depth == 0 || isGameOver())
+            return 1;
+        long long count = 0;
+        for (auto child : getCandidate())
         {
-            for (int j = 0; j < WIDTH; ++j)
-            {
-                board[i][j] = in_board[i][j];
-            }
+            int index = toIndex(child.x, child.y);
+            BoundingBox saved = board.bounds();
+            board.place(index, in_color);
+            count += perft(in_depth - 1, -in_color);
+            board.remove(index, saved);
         }
-        color = -1;
+        return count;
     }
 };
+
+// the engine of the caro games (caro_game.cpp, tournament.cpp)
+typedef GomokuEngine<CaroRule> Gomoku;
+
+#endif // CUSTOM_BOT
@@ -0,0 +1,242 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+
+#include "config.h"
+#include "custom_bot.h"
+#include "reference_bot.h"
+#include "rng.h"
+
+using namespace std;
+
+// differential test: the optimized engine against the reference engine (reference_bot.h),
+// once per win rule (rules.h), or only for the rule given by -rule
+// usage: differential_test [-positions N] [-games N] [-depth D] [-search-every K] [-perft D] [-seed S] [-rule caro|freestyle|exact]
+// every position compares getScore for both colors and both sides to move, the
+// candidate list (order included) and isGameOver; every K-th position also the
+// nextMove at depth D (solver and quiescence off, they have no reference).
+// Positions are random boards of every density plus self-play games of the reference.
+// -perft D also compares the number of candidate move sequences of length D.
+// A mismatch prints the position as an analyze.cpp line; the exit code is 1.
+
+const int MAX_RANDOM_STONES = 120;
+const int FULL_BOARD_EVERY = 50;   // random positions with (almost) every cell filled
+const int SELFPLAY_RANDOM = 30;    // percent of self-play moves drawn from the candidates
+const int PERFT_POSITIONS = 4;
+
+struct Totals{
+    long long positions;
+    long long searches;
+    long long perfts;
+    long long mismatches;
+};
+
+struct Options{
+    int num_positions;
+    int num_games;
+    int depth;
+    int search_every;
+    int perft_depth;
+    unsigned long long seed;
+};
+
+template <class Rule> long long run_rule(const char *name, const Options &options);
+void random_position(int board[][WIDTH], int &color, Rng &rng);
+template <class Rule> void check_position(int board[][WIDTH], int color, int depth, bool search, int perft_depth, Totals &totals);
+void print_position(int board[][WIDTH]);
+template <class Rule> void play_selfplay(Rng &rng, int depth, int search_every, int perft_depth, Totals &totals);
+
+int main(int argc, char **argv){
+    Options options;
+    options.num_positions = 500;
+    options.num_games = 10;
+    options.depth = 2;
+    options.search_every = 10;
+    options.perft_depth = 0;
+    options.seed = 1;
+    string rule = "all";
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(i + 1 >= argc){
+            cout<<"usage: differential_test [-positions N] [-games N] [-depth D] [-search-every K] [-perft D] [-seed S] [-rule caro|freestyle|exact]"<<endl;
+            return 1;
+        }
+        if(arg == "-positions") options.num_positions = atoi(argv[++i]);
+        else if(arg == "-games") options.num_games = atoi(argv[++i]);
+        else if(arg == "-depth") options.depth = atoi(argv[++i]);
+        else if(arg == "-search-every") options.search_every = atoi(argv[++i]);
+        else if(arg == "-perft") options.perft_depth = atoi(argv[++i]);
+        else if(arg == "-seed") options.seed = strtoull(argv[++i], NULL, 10);
+        else if(arg == "-rule") rule = argv[++i];
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+    if(rule != "all" && rule != "caro" && rule != "freestyle" && rule != "exact"){
+        cout<<"unknown rule "<<rule<<endl;
+        return 1;
+    }
+    if(options.depth < 1) options.depth = 1;
+    if(options.search_every < 1) options.search_every = 1;
+
+    long long mismatches = 0;
+    if(rule == "all" || rule == "caro") mismatches += run_rule<CaroRule>("caro", options);
+    if(rule == "all" || rule == "freestyle") mismatches += run_rule<FreestyleRule>("freestyle", options);
+    if(rule == "all" || rule == "exact") mismatches += run_rule<ExactFiveRule>("exact", options);
+    return mismatches ? 1 : 0;
+}
+
+// every rule sees the same positions, the reference self-play games follow the rule
+template <class Rule>
+long long run_rule(const char *name, const Options &options){
+    Rng rng(options.seed);
+    Totals totals = {};
+    auto start = chrono::steady_clock::now();
+    static int board[HEIGHT][WIDTH];
+    for(int i = 0; i < options.num_positions; i++){
+        int color;
+        random_position(board, color, rng);
+        check_position<Rule>(board, color, options.depth, i % options.search_every == 0,
+                             i < PERFT_POSITIONS ? options.perft_depth : 0, totals);
+    }
+    for(int game = 0; game < options.num_games; game++){
+        play_selfplay<Rule>(rng, options.depth, options.search_every, options.perft_depth, totals);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout<<name<<": "<<totals.positions<<" positions, "<<totals.searches<<" searches, "<<totals.perfts<<" perfts, "
+        <<totals.mismatches<<" mismatches in "<<seconds<<" s"<<endl;
+    return totals.mismatches;
+}
+
+// stones around a random center, colors alternate so 1 has as many stones as -1 or one more
+void random_position(int board[][WIDTH], int &color, Rng &rng){
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            board[i][j] = 0;
+        }
+    }
+    bool full = rng.below(FULL_BOARD_EVERY) == 0;
+    int stones = full ? HEIGHT * WIDTH - rng.below(3) : rng.below(MAX_RANDOM_STONES + 1);
+    int radius = full ? HEIGHT + WIDTH : 2 + rng.below(10);
+    int center_x = rng.below(HEIGHT), center_y = rng.below(WIDTH);
+    color = 1;
+    for(int placed = 0, tries = 0; placed < stones && tries < 100 * HEIGHT * WIDTH; tries++){
+        int x = center_x - radius + rng.below(2 * radius + 1);
+        int y = center_y - radius + rng.below(2 * radius + 1);
+        if(x < 0 || x >= HEIGHT || y < 0 || y >= WIDTH || board[x][y] != 0) continue;
+        board[x][y] = color;
+        color = -color;
+        placed++;
+    }
+}
+
+template <class Rule>
+void check_position(int board[][WIDTH], int color, int depth, bool search, int perft_depth, Totals &totals){
+    static ReferenceEngine<Rule> reference;
+    static GomokuEngine<Rule> optimized;
+    vector<string> errors;
+    totals.positions++;
+
+    reference.initBoard(board);
+    optimized.initBoard(board);
+    for(int in_color = -1; in_color <= 1; in_color += 2){
+        for(int next_color = -1; next_color <= 1; next_color += 2){
+            int expected = reference.getScore(in_color, next_color);
+            int actual = optimized.scoreOf(in_color, next_color);
+            if(expected != actual){
+                errors.push_back("getScore(" + to_string(in_color) + ", " + to_string(next_color) + ") "
+                                 + to_string(actual) + " expected " + to_string(expected));
+            }
+        }
+    }
+    vector<Point> expected_candidates = reference.getCandidate();
+    vector<Point> actual_candidates = optimized.candidates();
+    bool same = expected_candidates.size() == actual_candidates.size();
+    for(size_t i = 0; same && i < expected_candidates.size(); i++){
+        same = expected_candidates[i].x == actual_candidates[i].x && expected_candidates[i].y == actual_candidates[i].y;
+    }
+    if(!same){
+        errors.push_back("getCandidate: " + to_string(actual_candidates.size()) + " candidates, expected "
+                         + to_string(expected_candidates.size()) + " or a different order");
+    }
+    if(reference.isGameOver() != optimized.gameOver()){
+        errors.push_back(string("isGameOver ") + (optimized.gameOver() ? "true" : "false"));
+    }
+    if(perft_depth > 0){
+        totals.perfts++;
+        long long expected = reference.perft(perft_depth, color);
+        long long actual = optimized.perft(perft_depth, color);
+        if(expected != actual){
+            errors.push_back("perft(" + to_string(perft_depth) + ") " + to_string(actual) + " expected " + to_string(expected));
+        }
+    }
+    if(search){
+        totals.searches++;
+        reference.depth = depth;
+        GomokuEngine<Rule> engine;
+        engine.setDepth(depth);
+        engine.setSolver(false);
+        engine.setQuiescence(QUIESCENCE_OFF);
+        engine.setDeterministic(true);
+        Point expected = reference.nextMove(board, color);
+        Point actual = engine.nextMove(board, color);
+        if(expected.x != actual.x || expected.y != actual.y){
+            errors.push_back("nextMove(depth " + to_string(depth) + ") " + to_string(actual.x) + "," + to_string(actual.y)
+                             + " expected " + to_string(expected.x) + "," + to_string(expected.y));
+        }
+    }
+
+    if(errors.empty()) return;
+    totals.mismatches += errors.size();
+    cout<<"mismatch at position "<<totals.positions<<", "<<color<<" to move:"<<endl;
+    for(auto &error : errors) cout<<"  "<<error<<endl;
+    cout<<"  ";
+    print_position(board);
+}
+
+// the stones as an analyze.cpp text line, 1 and -1 alternating
+void print_position(int board[][WIDTH]){
+    vector<Point> stones[2];
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            if(board[i][j] != 0) stones[board[i][j] == 1 ? 0 : 1].push_back(Point(i, j));
+        }
+    }
+    for(size_t i = 0; i < stones[0].size() || i < stones[1].size(); i++){
+        for(int side = 0; side < 2; side++){
+            if(i < stones[side].size()) cout<<stones[side][i].x<<","<<stones[side][i].y<<" ";
+        }
+    }
+    cout<<endl;
+}
+
+// the reference plays itself at depth 1, some moves are random candidates so games differ
+template <class Rule>
+void play_selfplay(Rng &rng, int depth, int search_every, int perft_depth, Totals &totals){
+    static int board[HEIGHT][WIDTH];
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            board[i][j] = 0;
+        }
+    }
+    ReferenceEngine<Rule> player;
+    player.depth = 1;
+    int color = 1;
+    for(int ply = 0; ply < HEIGHT * WIDTH; ply++){
+        check_position<Rule>(board, color, depth, ply % search_every == 0, ply == 8 ? perft_depth : 0, totals);
+        Point move = player.nextMove(board, color);
+        if(ply >= 4 && rng.below(100) < SELFPLAY_RANDOM){
+            vector<Point> candidates = player.getCandidate();
+            if(!candidates.empty()) move = candidates[rng.below((int)candidates.size())];
+        }
+        if(move.x < 0 || move.x >= HEIGHT || move.y < 0 || move.y >= WIDTH || board[move.x][move.y] != 0) return;
+        board[move.x][move.y] = color;
+        player.initBoard(board);
+        if(player.isGameOver()) return;
+        color = -color;
+    }
+}
@@ -0,0 +1,366 @@
+#ifndef GAME_RECORD
+#define GAME_RECORD
+
+#include <vector>
+#include <limits.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "rules.h"
+
+// Binary game record, games are appended one after another.
+// Every integer is an unsigned LEB128 varint, signed values are zigzag encoded.
+//   'G' 'R' version flags
+//   height width rule result(signed) move_count payload_size
+//   payload: move_count times { cell(row * width + col) [time_us] [depth] [score(signed)] }
+// The first move is played by color 1 and colors alternate.
+
+const unsigned char RECORD_MAGIC_0 = 'G';
+const unsigned char RECORD_MAGIC_1 = 'R';
+const unsigned char RECORD_VERSION = 1;
+
+// optional per move fields
+const int RECORD_HAS_TIME = 1;
+const int RECORD_HAS_DEPTH = 2;
+const int RECORD_HAS_SCORE = 4;
+
+// the rule field holds a RULE_* id of rules.h
+
+struct RecordMove
+{
+    Point point;
+    long long time_us;
+    int depth;
+    long long score;
+};
+
+inline void putVarint(std::vector<unsigned char> &out, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+inline void putSigned(std::vector<unsigned char> &out, long long value)
+{
+    putVarint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+// return false when the varint runs past end
+inline bool getVarint(const unsigned char *&data, const unsigned char *end, unsigned long long &value)
+{
+    value = 0;
+    for (int shift = 0; data < end && shift < 64; shift += 7)
+    {
+        unsigned char byte = *data++;
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline bool getSigned(const unsigned char *&data, const unsigned char *end, long long &value)
+{
+    unsigned long long raw;
+    if (!getVarint(data, end, raw))
+        return false;
+    value = (long long)(raw >> 1) ^ -(long long)(raw & 1);
+    return true;
+}
+
+// append-only writer, a game is buffered and written with a single write call
+// so several processes can share one file opened in append mode
+class GameRecordWriter
+{
+private:
+    int fd;
+    int flags;
+    int rule;
+    int move_count;
+    std::vector<unsigned char> payload;
+    std::vector<unsigned char> buffer;
+
+public:
+    GameRecordWriter()
+    {
+        fd = -1;
+        flags = 0;
+        rule = RULE_CARO;
+        move_count = 0;
+    }
+
+    ~GameRecordWriter()
+    {
+        close();
+    }
+
+    bool open(const char *path)
+    {
+        close();
+        fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        return fd >= 0;
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+
+    // start a new game, in_flags is a mask of RECORD_HAS_*
+    void beginGame(int in_flags, int in_rule = RULE_CARO)
+    {
+        flags = in_flags;
+        rule = in_rule;
+        move_count = 0;
+        payload.clear();
+    }
+
+    void addMove(Point point, long long time_us = 0, int depth = 0, long long score = 0)
+    {
+        putVarint(payload, (unsigned long long)(point.x * WIDTH + point.y));
+        if (flags & RECORD_HAS_TIME)
+            putVarint(payload, (unsigned long long)time_us);
+        if (flags & RECORD_HAS_DEPTH)
+            putVarint(payload, (unsigned long long)depth);
+        if (flags & RECORD_HAS_SCORE)
+            putSigned(payload, score);
+        move_count++;
+    }
+
+    // result is the winning color (1 or -1) or 0 for a draw
+    bool endGame(int result)
+    {
+        buffer.clear();
+        buffer.push_back(RECORD_MAGIC_0);
+        buffer.push_back(RECORD_MAGIC_1);
+        buffer.push_back(RECORD_VERSION);
+        buffer.push_back((unsigned char)flags);
+        putVarint(buffer, HEIGHT);
+        putVarint(buffer, WIDTH);
+        putVarint(buffer, rule);
+        putSigned(buffer, result);
+        putVarint(buffer, move_count);
+        putVarint(buffer, payload.size());
+        buffer.insert(buffer.end(), payload.begin(), payload.end());
+        if (fd < 0)
+            return false;
+        return write(fd, buffer.data(), buffer.size()) == (ssize_t)buffer.size();
+    }
+};
+
+// decodes the moves of one game lazily
+class RecordMoveIterator
+{
+private:
+    const unsigned char *data;
+    const unsigned char *end;
+    int flags;
+    int width;
+
+public:
+    RecordMoveIterator(const unsigned char *in_data, const unsigned char *in_end, int in_flags, int in_width)
+    {
+        data = in_data;
+        end = in_end;
+        flags = in_flags;
+        width = in_width;
+    }
+
+    bool next(RecordMove &move)
+    {
+        unsigned long long value;
+        if (data >= end || !getVarint(data, end, value))
+            return false;
+        // a corrupt cell that doesn't fit an int reads as off the board
+        if (value / width > (unsigned long long)INT_MAX)
+            move.point = Point(-1, -1);
+        else
+            move.point = Point((int)(value / width), (int)(value % width));
+        move.time_us = 0;
+        move.depth = 0;
+        move.score = 0;
+        if (flags & RECORD_HAS_TIME)
+        {
+            if (!getVarint(data, end, value))
+                return false;
+            move.time_us = (long long)value;
+        }
+        if (flags & RECORD_HAS_DEPTH)
+        {
+            if (!getVarint(data, end, value))
+                return false;
+            move.depth = (int)value;
+        }
+        if (flags & RECORD_HAS_SCORE)
+        {
+            if (!getSigned(data, end, move.score))
+                return false;
+        }
+        return true;
+    }
+
+    // true once every move of the payload has been decoded
+    bool done() const
+    {
+        return data >= end;
+    }
+};
+
+// header of one game inside the mapped file
+struct GameView
+{
+    int flags;
+    int height, width;
+    int rule;
+    int result;
+    int move_count;
+    const unsigned char *payload;
+    const unsigned char *payload_end;
+
+    RecordMoveIterator moves() const
+    {
+        return RecordMoveIterator(payload, payload_end, flags, width);
+    }
+};
+
+// the moves of game when they can be replayed on the HEIGHT x WIDTH board:
+// false when the board size differs, the payload is cut short or a move is
+// off the board or on an occupied cell
+inline bool readGameMoves(const GameView &game, std::vector<Point> &moves)
+{
+    moves.clear();
+    if (game.height != HEIGHT || game.width != WIDTH)
+        return false;
+    std::vector<char> occupied(HEIGHT * WIDTH, 0);
+    RecordMoveIterator iterator = game.moves();
+    RecordMove move;
+    while (iterator.next(move))
+    {
+        if (move.point.x < 0 || move.point.x >= HEIGHT || move.point.y < 0 || move.point.y >= WIDTH)
+            return false;
+        char &cell = occupied[move.point.x * WIDTH + move.point.y];
+        if (cell)
+            return false;
+        cell = 1;
+        moves.push_back(move.point);
+    }
+    return iterator.done() && (int)moves.size() == game.move_count;
+}
+
+// mmap based reader, next() only decodes headers and skips over the payload
+class GameRecordReader
+{
+private:
+    const unsigned char *base;
+    size_t size;
+    size_t offset;
+    bool corrupt_flag;
+
+public:
+    GameRecordReader()
+    {
+        base = NULL;
+        size = 0;
+        offset = 0;
+        corrupt_flag = false;
+    }
+
+    ~GameRecordReader()
+    {
+        close();
+    }
+
+    bool open(const char *path)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        if (size > 0)
+        {
+            void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                size = 0;
+                return false;
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            base = (const unsigned char *)mapped;
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close()
+    {
+        if (base)
+            munmap((void *)base, size);
+        base = NULL;
+        size = 0;
+        offset = 0;
+        corrupt_flag = false;
+    }
+
+    void rewind()
+    {
+        offset = 0;
+        corrupt_flag = false;
+    }
+
+    // true when the last next() stopped on a corrupt record instead of the end of file
+    bool corrupt() const
+    {
+        return corrupt_flag;
+    }
+
+    // read the next game header, return false at the end of file or on a corrupt record
+    bool next(GameView &game)
+    {
+        const unsigned char *data = base + offset;
+        const unsigned char *end = base + size;
+        if (!base || data == end)
+            return false;
+        // nothing after a corrupt header can be trusted, reading stops there
+        corrupt_flag = true;
+        if (end - data < 4 || data[0] != RECORD_MAGIC_0 || data[1] != RECORD_MAGIC_1 || data[2] != RECORD_VERSION)
+            return false;
+        game.flags = data[3];
+        data += 4;
+        unsigned long long height, width, rule, move_count, payload_size;
+        long long result;
+        if (!getVarint(data, end, height) || !getVarint(data, end, width) || !getVarint(data, end, rule) ||
+            !getSigned(data, end, result) || !getVarint(data, end, move_count) || !getVarint(data, end, payload_size))
+            return false;
+        if (width == 0 || payload_size > (unsigned long long)(end - data))
+            return false;
+        game.height = (int)height;
+        game.width = (int)width;
+        game.rule = (int)rule;
+        game.result = (int)result;
+        game.move_count = (int)move_count;
+        game.payload = data;
+        game.payload_end = data + payload_size;
+        offset = game.payload_end - base;
+        corrupt_flag = false;
+        return true;
+    }
+};
+
+#endif // GAME_RECORD
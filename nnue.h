@@ -0,0 +1,241 @@
+#ifndef NNUE
+#define NNUE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Efficiently updatable evaluation: one input per cell and color, a hidden layer
+// whose sums (the accumulator) are kept up to date on every place / remove,
+// then a clipped ReLU and one output per side to move.
+// Quantization: hidden sums are scaled by NNUE_QA and clipped to [0, NNUE_QA],
+// output weights by NNUE_QB, so output / (NNUE_QA * NNUE_QB) is the float logit
+// (white's point of view) the weights were trained for.
+// Weights and biases are int16, the accumulator is int32: a hidden sum holds the
+// bias and at most one weight per cell, which fits for any int16 weights, so the
+// full int16 range is usable and every place / remove is exactly reversible.
+const int NNUE_HIDDEN = 32; // multiple of 32 for the SIMD paths
+const int NNUE_FEATURES = 2 * HEIGHT * WIDTH;
+const int NNUE_QA = 127;
+const int NNUE_QB = 64;
+const char NNUE_MAGIC[4] = {'G', 'N', 'N', '1'};
+
+static_assert(32768LL * (HEIGHT * WIDTH + 1) <= 2147483647LL, "a hidden sum must fit in the int32 accumulator");
+
+inline int nnueFeature(int cell, int value)
+{
+    return cell * 2 + (value > 0);
+}
+
+struct Accumulator
+{
+    alignas(32) int32_t values[NNUE_HIDDEN];
+};
+
+class Network
+{
+private:
+    std::vector<int16_t> feature_weights; // NNUE_FEATURES x NNUE_HIDDEN
+    alignas(32) int16_t feature_bias[NNUE_HIDDEN];
+    alignas(32) int8_t output_weights[2][NNUE_HIDDEN]; // [0] white to move, [1] black to move
+    int32_t output_bias[2];
+
+public:
+    Network()
+    {
+        feature_weights.assign((size_t)NNUE_FEATURES * NNUE_HIDDEN, 0);
+        memset(feature_bias, 0, sizeof(feature_bias));
+        memset(output_weights, 0, sizeof(output_weights));
+        output_bias[0] = output_bias[1] = 0;
+    }
+
+    int16_t *featureWeights(int feature)
+    {
+        return &feature_weights[(size_t)feature * NNUE_HIDDEN];
+    }
+
+    int16_t *featureBias()
+    {
+        return feature_bias;
+    }
+
+    int8_t *outputWeights(int side)
+    {
+        return output_weights[side];
+    }
+
+    int32_t &outputBias(int side)
+    {
+        return output_bias[side];
+    }
+
+    void reset(Accumulator &acc) const
+    {
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+            acc.values[i] = feature_bias[i];
+    }
+
+    void add(Accumulator &acc, int feature) const
+    {
+        const int16_t *column = &feature_weights[(size_t)feature * NNUE_HIDDEN];
+#if defined(__AVX2__)
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m256i weights = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(column + i)));
+            __m256i sum = _mm256_add_epi32(_mm256_load_si256((const __m256i *)(acc.values + i)), weights);
+            _mm256_store_si256((__m256i *)(acc.values + i), sum);
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            // sign extend the int16 weights to int32
+            __m128i weights = _mm_loadu_si128((const __m128i *)(column + i));
+            __m128i sign = _mm_srai_epi16(weights, 15);
+            __m128i low = _mm_add_epi32(_mm_load_si128((const __m128i *)(acc.values + i)), _mm_unpacklo_epi16(weights, sign));
+            __m128i high = _mm_add_epi32(_mm_load_si128((const __m128i *)(acc.values + i + 4)), _mm_unpackhi_epi16(weights, sign));
+            _mm_store_si128((__m128i *)(acc.values + i), low);
+            _mm_store_si128((__m128i *)(acc.values + i + 4), high);
+        }
+#else
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+            acc.values[i] += column[i];
+#endif
+    }
+
+    void sub(Accumulator &acc, int feature) const
+    {
+        const int16_t *column = &feature_weights[(size_t)feature * NNUE_HIDDEN];
+#if defined(__AVX2__)
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m256i weights = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(column + i)));
+            __m256i diff = _mm256_sub_epi32(_mm256_load_si256((const __m256i *)(acc.values + i)), weights);
+            _mm256_store_si256((__m256i *)(acc.values + i), diff);
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i weights = _mm_loadu_si128((const __m128i *)(column + i));
+            __m128i sign = _mm_srai_epi16(weights, 15);
+            __m128i low = _mm_sub_epi32(_mm_load_si128((const __m128i *)(acc.values + i)), _mm_unpacklo_epi16(weights, sign));
+            __m128i high = _mm_sub_epi32(_mm_load_si128((const __m128i *)(acc.values + i + 4)), _mm_unpackhi_epi16(weights, sign));
+            _mm_store_si128((__m128i *)(acc.values + i), low);
+            _mm_store_si128((__m128i *)(acc.values + i + 4), high);
+        }
+#else
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+            acc.values[i] -= column[i];
+#endif
+    }
+
+    // quantized output for next_color to move
+    int32_t propagate(const Accumulator &acc, int next_color) const
+    {
+        int side = next_color == 1 ? 0 : 1;
+        const int8_t *weights = output_weights[side];
+        int32_t sum = 0;
+#if defined(__AVX2__)
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i top = _mm256_set1_epi16(NNUE_QA);
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i total = _mm256_setzero_si256();
+        for (int i = 0; i < NNUE_HIDDEN; i += 32)
+        {
+            // saturating to int16 keeps the clip below exact; packs works per 128 bit lane
+            __m256i low = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_load_si256((const __m256i *)(acc.values + i)),
+                                                                      _mm256_load_si256((const __m256i *)(acc.values + i + 8))), 0xD8);
+            __m256i high = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_load_si256((const __m256i *)(acc.values + i + 16)),
+                                                                       _mm256_load_si256((const __m256i *)(acc.values + i + 24))), 0xD8);
+            low = _mm256_min_epi16(_mm256_max_epi16(low, zero), top);
+            high = _mm256_min_epi16(_mm256_max_epi16(high, zero), top);
+            // packs works per 128 bit lane, the permute restores the order
+            __m256i clipped = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+            __m256i products = _mm256_maddubs_epi16(clipped, _mm256_load_si256((const __m256i *)(weights + i)));
+            total = _mm256_add_epi32(total, _mm256_madd_epi16(products, ones));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        sum = _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i top = _mm_set1_epi16(NNUE_QA);
+        __m128i total = _mm_setzero_si128();
+        for (int i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            // saturating to int16 keeps the clip exact
+            __m128i low = _mm_packs_epi32(_mm_load_si128((const __m128i *)(acc.values + i)),
+                                          _mm_load_si128((const __m128i *)(acc.values + i + 4)));
+            __m128i high = _mm_packs_epi32(_mm_load_si128((const __m128i *)(acc.values + i + 8)),
+                                           _mm_load_si128((const __m128i *)(acc.values + i + 12)));
+            low = _mm_min_epi16(_mm_max_epi16(low, zero), top);
+            high = _mm_min_epi16(_mm_max_epi16(high, zero), top);
+            // sign extend the int8 weights to int16
+            __m128i packed = _mm_load_si128((const __m128i *)(weights + i));
+            __m128i sign = _mm_cmpgt_epi8(zero, packed);
+            total = _mm_add_epi32(total, _mm_madd_epi16(low, _mm_unpacklo_epi8(packed, sign)));
+            total = _mm_add_epi32(total, _mm_madd_epi16(high, _mm_unpackhi_epi8(packed, sign)));
+        }
+        total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4E));
+        total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xB1));
+        sum = _mm_cvtsi128_si32(total);
+#else
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+        {
+            int value = acc.values[i] < 0 ? 0 : (acc.values[i] > NNUE_QA ? NNUE_QA : acc.values[i]);
+            sum += value * weights[i];
+        }
+#endif
+        return sum + output_bias[side];
+    }
+
+    // float logit for next_color to move, white's point of view
+    double evaluate(const Accumulator &acc, int next_color) const
+    {
+        return (double)propagate(acc, next_color) / (NNUE_QA * NNUE_QB);
+    }
+
+    // file: magic, height, width, hidden (int32), then the arrays in declaration order
+    bool load(const char *path)
+    {
+        FILE *file = fopen(path, "rb");
+        if (!file)
+            return false;
+        char magic[4];
+        int32_t shape[3];
+        bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, NNUE_MAGIC, 4) == 0 &&
+                  fread(shape, sizeof(int32_t), 3, file) == 3 &&
+                  shape[0] == HEIGHT && shape[1] == WIDTH && shape[2] == NNUE_HIDDEN &&
+                  fread(feature_weights.data(), sizeof(int16_t), feature_weights.size(), file) == feature_weights.size() &&
+                  fread(feature_bias, sizeof(feature_bias), 1, file) == 1 &&
+                  fread(output_weights, sizeof(output_weights), 1, file) == 1 &&
+                  fread(output_bias, sizeof(output_bias), 1, file) == 1;
+        fclose(file);
+        return ok;
+    }
+
+    bool save(const char *path) const
+    {
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return false;
+        int32_t shape[3] = {HEIGHT, WIDTH, NNUE_HIDDEN};
+        bool ok = fwrite(NNUE_MAGIC, 1, 4, file) == 4 && fwrite(shape, sizeof(int32_t), 3, file) == 3 &&
+                  fwrite(feature_weights.data(), sizeof(int16_t), feature_weights.size(), file) == feature_weights.size() &&
+                  fwrite(feature_bias, sizeof(feature_bias), 1, file) == 1 &&
+                  fwrite(output_weights, sizeof(output_weights), 1, file) == 1 &&
+                  fwrite(output_bias, sizeof(output_bias), 1, file) == 1;
+        fclose(file);
+        return ok;
+    }
+};
+
+#endif // NNUE
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "config.h"
+#include "board.h"
+#include "nnue.h"
+#include "rng.h"
+
+using namespace std;
+
+// checks the compiled accumulator / output path of nnue.h against plain int32 sums
+// usage: nnue_test [-games N] [-seed S] [-file path]
+// Build it once per path: -mavx2, the default SSE2, and -U__SSE2__ for the scalar loops.
+// Two networks go through save / load and random games up to a full board with
+// place / remove: one with every weight and bias at +-32767, the largest sums the
+// int32 accumulator ever holds, and one with small random weights whose sums land
+// inside the clipped range. Every position compares the incremental accumulator,
+// a refreshed one and both outputs with the reference.
+
+const int CHECK_EVERY = 7; // plies between two checks of a game
+const int SMALL_WEIGHT = 40;
+
+struct Reference{
+    long long hidden[NNUE_HIDDEN];
+};
+
+long long mismatches = 0;
+
+int random_weight(int limit, bool extreme, Rng &rng);
+void random_network(Network &net, int limit, bool extreme, Rng &rng);
+long long play_games(Network &net, int games, Rng &rng);
+void reference_sums(Network &net, const Board &board, Reference &ref);
+long long reference_output(Network &net, const Reference &ref, int next_color);
+void check(Network &net, const Board &board, const string &where);
+
+int main(int argc, char **argv){
+    int games = 20;
+    unsigned long long seed = 1;
+    string path = "/tmp/nnue_test.bin";
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(i + 1 >= argc){
+            cout<<"usage: nnue_test [-games N] [-seed S] [-file path]"<<endl;
+            return 1;
+        }
+        if(arg == "-games") games = atoi(argv[++i]);
+        else if(arg == "-seed") seed = strtoull(argv[++i], NULL, 10);
+        else if(arg == "-file") path = argv[++i];
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+#if defined(__AVX2__)
+    cout<<"path avx2"<<endl;
+#elif defined(__SSE2__)
+    cout<<"path sse2"<<endl;
+#else
+    cout<<"path scalar"<<endl;
+#endif
+    Rng rng(seed);
+
+    static Network network;
+    static Network loaded;
+    long long checks = 0;
+    for(int extreme = 1; extreme >= 0; extreme--){
+        random_network(network, extreme ? 32767 : SMALL_WEIGHT, extreme, rng);
+        if(!network.save(path.c_str()) || !loaded.load(path.c_str())){
+            cout<<"can't write and read back "<<path<<endl;
+            return 1;
+        }
+        checks += play_games(loaded, games, rng);
+    }
+    cout<<checks<<" positions, "<<mismatches<<" mismatches"<<endl;
+    return mismatches ? 1 : 0;
+}
+
+// random games up to a full board, a few moves taken back on the way; checked positions
+long long play_games(Network &net, int games, Rng &rng){
+    static Board board;
+    static Board refreshed;
+    static int plain[HEIGHT][WIDTH];
+    long long checks = 0;
+    for(int game = 0; game < games; game++){
+        for(int i = 0; i < HEIGHT; i++){
+            for(int j = 0; j < WIDTH; j++){
+                plain[i][j] = 0;
+            }
+        }
+        board.setNetwork(&net);
+        board.load(plain);
+        vector<int> cells;
+        for(int i = 0; i < HEIGHT * WIDTH; i++) cells.push_back(i);
+        for(int i = HEIGHT * WIDTH - 1; i > 0; i--) swap(cells[i], cells[rng.below(i + 1)]);
+        int color = 1;
+        for(int ply = 0; ply < HEIGHT * WIDTH; ply++){
+            int row = cells[ply] / WIDTH, col = cells[ply] % WIDTH;
+            int index = toIndex(row, col);
+            BoundingBox saved = board.bounds();
+            board.place(index, color);
+            if(rng.below(4) == 0){
+                board.remove(index, saved);
+                board.place(index, color);
+            }
+            plain[row][col] = color;
+            color = -color;
+            if(ply % CHECK_EVERY == 0 || ply == HEIGHT * WIDTH - 1){
+                string where = "game " + to_string(game) + " ply " + to_string(ply);
+                check(net, board, where + " incremental");
+                refreshed.setNetwork(&net);
+                refreshed.load(plain);
+                check(net, refreshed, where + " refreshed");
+                checks++;
+            }
+        }
+    }
+    return checks;
+}
+
+// weights and biases +-limit when extreme, else anywhere in [-limit, limit];
+// output weights over the whole int8 range
+int random_weight(int limit, bool extreme, Rng &rng){
+    if(extreme) return rng.below(2) ? limit : -limit;
+    return rng.below(2 * limit + 1) - limit;
+}
+
+void random_network(Network &net, int limit, bool extreme, Rng &rng){
+    for(int feature = 0; feature < NNUE_FEATURES; feature++){
+        int16_t *column = net.featureWeights(feature);
+        for(int i = 0; i < NNUE_HIDDEN; i++) column[i] = (int16_t)random_weight(limit, extreme, rng);
+    }
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        net.featureBias()[i] = (int16_t)random_weight(limit, extreme, rng);
+        for(int side = 0; side < 2; side++) net.outputWeights(side)[i] = (int8_t)((int)rng.below(255) - 127);
+    }
+    for(int side = 0; side < 2; side++) net.outputBias(side) = (int32_t)rng.below(20001) - 10000;
+}
+
+void reference_sums(Network &net, const Board &board, Reference &ref){
+    for(int i = 0; i < NNUE_HIDDEN; i++) ref.hidden[i] = net.featureBias()[i];
+    for(int row = 0; row < HEIGHT; row++){
+        for(int col = 0; col < WIDTH; col++){
+            int value = board[toIndex(row, col)];
+            if(value == 0) continue;
+            const int16_t *column = net.featureWeights(nnueFeature(row * WIDTH + col, value));
+            for(int i = 0; i < NNUE_HIDDEN; i++) ref.hidden[i] += column[i];
+        }
+    }
+}
+
+long long reference_output(Network &net, const Reference &ref, int next_color){
+    int side = next_color == 1 ? 0 : 1;
+    long long sum = net.outputBias(side);
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        long long value = ref.hidden[i] < 0 ? 0 : (ref.hidden[i] > NNUE_QA ? NNUE_QA : ref.hidden[i]);
+        sum += value * net.outputWeights(side)[i];
+    }
+    return sum;
+}
+
+void check(Network &net, const Board &board, const string &where){
+    Reference ref;
+    reference_sums(net, board, ref);
+    const Accumulator &acc = board.accumulator();
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        if(acc.values[i] != ref.hidden[i]){
+            cout<<where<<": hidden "<<i<<" "<<acc.values[i]<<" expected "<<ref.hidden[i]<<endl;
+            mismatches++;
+            return;
+        }
+    }
+    for(int next_color = -1; next_color <= 1; next_color += 2){
+        long long expected = reference_output(net, ref, next_color);
+        long long actual = net.propagate(acc, next_color);
+        if(actual != expected){
+            cout<<where<<": output "<<actual<<" expected "<<expected<<" for "<<next_color<<endl;
+            mismatches++;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <stdlib.h>
+
+#include "config.h"
+#include "game_record.h"
+#include "nnue.h"
+
+using namespace std;
+
+// trains the nnue.h network on game records and writes quantized weights
+// usage: nnue_train <records> <weights out> [-epochs N] [-lr x] [-min-ply N]
+// every position of every game is labeled with the game result (white wins 1, draw 0.5, black wins 0)
+
+// float version of the network, same shape as Network
+struct FloatNetwork{
+    vector<float> feature_weights;
+    float feature_bias[NNUE_HIDDEN];
+    float output_weights[2][NNUE_HIDDEN];
+    float output_bias[2];
+};
+
+const float MAX_OUTPUT_WEIGHT = 127.0f / NNUE_QB;
+// feature weights and biases, within int16 once quantized
+const float MAX_FEATURE_WEIGHT = 32767.0f / NNUE_QA;
+
+float random_weight(unsigned long long &state, float scale);
+double train_position(FloatNetwork &net, const vector<int> &features, int side, float target, float lr);
+void quantize(const FloatNetwork &net, Network &out);
+
+int main(int argc, char **argv){
+    if(argc < 3){
+        cout<<"usage: nnue_train <records> <weights out> [-epochs N] [-lr x] [-min-ply N]"<<endl;
+        return 1;
+    }
+    int epochs = 10;
+    float lr = 0.01f;
+    int min_ply = 4;
+    for(int i = 3; i + 1 < argc; i += 2){
+        string arg = argv[i];
+        if(arg == "-epochs") epochs = atoi(argv[i+1]);
+        else if(arg == "-lr") lr = atof(argv[i+1]);
+        else if(arg == "-min-ply") min_ply = atoi(argv[i+1]);
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+
+    GameRecordReader reader;
+    if(!reader.open(argv[1])){
+        cout<<"can't read "<<argv[1]<<endl;
+        return 1;
+    }
+
+    FloatNetwork net;
+    unsigned long long seed = 12345;
+    net.feature_weights.resize((size_t)NNUE_FEATURES * NNUE_HIDDEN);
+    for(auto &weight : net.feature_weights) weight = random_weight(seed, 0.1f);
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        net.feature_bias[i] = 0.1f;
+        net.output_weights[0][i] = random_weight(seed, 0.5f);
+        net.output_weights[1][i] = random_weight(seed, 0.5f);
+    }
+    net.output_bias[0] = net.output_bias[1] = 0;
+
+    vector<int> features;
+    vector<Point> moves;
+    for(int epoch = 1; epoch <= epochs; epoch++){
+        reader.rewind();
+        GameView game;
+        double loss = 0;
+        long long positions = 0, skipped = 0;
+        while(reader.next(game)){
+            // the network evaluates for the caro engine; games of another rule or
+            // board, or with a bad move, are skipped whole
+            if(game.rule != RULE_CARO || !readGameMoves(game, moves)){
+                skipped++;
+                continue;
+            }
+            float target = game.result == 1 ? 1.0f : (game.result == -1 ? 0.0f : 0.5f);
+            features.clear();
+            int color = 1;
+            for(const Point &move : moves){
+                if((int)features.size() >= min_ply){
+                    loss += train_position(net, features, color, target, lr);
+                    positions++;
+                }
+                features.push_back(nnueFeature(move.x * WIDTH + move.y, color));
+                color = -color;
+            }
+        }
+        cout<<"epoch "<<epoch<<" positions "<<positions<<" loss "<<fixed<<setprecision(5)
+            <<(positions ? loss / positions : 0)<<endl;
+        if(epoch == 1 && skipped > 0) cout<<"skipped "<<skipped<<" games of another rule or board, or with invalid moves"<<endl;
+        if(epoch == 1 && reader.corrupt()) cout<<"corrupt record, the rest of "<<argv[1]<<" is ignored"<<endl;
+    }
+
+    Network quantized;
+    quantize(net, quantized);
+    if(!quantized.save(argv[2])){
+        cout<<"can't write "<<argv[2]<<endl;
+        return 1;
+    }
+    return 0;
+}
+
+float random_weight(unsigned long long &state, float scale){
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((state >> 40) / (float)(1 << 24) * 2 - 1) * scale;
+}
+
+// one SGD step on the cross entropy of sigmoid(output), return the loss
+double train_position(FloatNetwork &net, const vector<int> &features, int color, float target, float lr){
+    int side = color == 1 ? 0 : 1;
+    float hidden[NNUE_HIDDEN], active[NNUE_HIDDEN];
+    for(int i = 0; i < NNUE_HIDDEN; i++) hidden[i] = net.feature_bias[i];
+    for(int feature : features){
+        const float *column = &net.feature_weights[(size_t)feature * NNUE_HIDDEN];
+        for(int i = 0; i < NNUE_HIDDEN; i++) hidden[i] += column[i];
+    }
+    float output = net.output_bias[side];
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        active[i] = min(1.0f, max(0.0f, hidden[i]));
+        output += active[i] * net.output_weights[side][i];
+    }
+    float predicted = 1 / (1 + exp(-output));
+    float grad = predicted - target;
+
+    float hidden_grad[NNUE_HIDDEN];
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        hidden_grad[i] = (hidden[i] > 0 && hidden[i] < 1) ? grad * net.output_weights[side][i] * lr : 0;
+        float weight = net.output_weights[side][i] - lr * grad * active[i];
+        net.output_weights[side][i] = min(MAX_OUTPUT_WEIGHT, max(-MAX_OUTPUT_WEIGHT, weight));
+        net.feature_bias[i] = min(MAX_FEATURE_WEIGHT, max(-MAX_FEATURE_WEIGHT, net.feature_bias[i] - hidden_grad[i]));
+    }
+    net.output_bias[side] -= lr * grad;
+    for(int feature : features){
+        float *column = &net.feature_weights[(size_t)feature * NNUE_HIDDEN];
+        for(int i = 0; i < NNUE_HIDDEN; i++){
+            column[i] = min(MAX_FEATURE_WEIGHT, max(-MAX_FEATURE_WEIGHT, column[i] - hidden_grad[i]));
+        }
+    }
+
+    float p = min(1 - 1e-6f, max(1e-6f, predicted));
+    return -(target * log(p) + (1 - target) * log(1 - p));
+}
+
+void quantize(const FloatNetwork &net, Network &out){
+    for(int feature = 0; feature < NNUE_FEATURES; feature++){
+        int16_t *column = out.featureWeights(feature);
+        for(int i = 0; i < NNUE_HIDDEN; i++){
+            column[i] = (int16_t)lround(net.feature_weights[(size_t)feature * NNUE_HIDDEN + i] * NNUE_QA);
+        }
+    }
+    for(int i = 0; i < NNUE_HIDDEN; i++){
+        out.featureBias()[i] = (int16_t)lround(net.feature_bias[i] * NNUE_QA);
+        for(int side = 0; side < 2; side++){
+            out.outputWeights(side)[i] = (int8_t)lround(net.output_weights[side][i] * NNUE_QB);
+        }
+    }
+    for(int side = 0; side < 2; side++){
+        out.outputBias(side) = (int32_t)lround(net.output_bias[side] * NNUE_QA * NNUE_QB);
+    }
+}
@@ -0,0 +1,329 @@
+#ifndef PN_SOLVER
+#define PN_SOLVER
+
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include "config.h"
+#include "board.h"
+
+// result of ProofNumberSolver::solve
+const int SOLVER_UNKNOWN = 0;
+const int SOLVER_WIN = 1;
+
+const unsigned PN_INF = 1u << 30;
+const int SOLVER_POLL = 32; // iterations between two calls of the abort check
+
+struct ProofNode
+{
+    unsigned pn, dn;
+    bool attacker_turn;
+    bool expanded;
+    int first_child; // into links
+    int num_children;
+    int move;        // winning move (board index) of a proven attacker node
+};
+
+struct ProofLink
+{
+    int move;
+    int node;
+};
+
+// Proof-number search over continuous fours (VCF): the attacker only plays
+// moves that make a four, so the defender only has the replies that stop every
+// five square (defences), all of them are searched. Positions are
+// shared through their Zobrist key, which turns the tree into a DAG.
+// A win is a real proof under Rule; UNKNOWN means no VCF was found within the limits.
+template <class Rule>
+class ProofNumberSolver
+{
+private:
+    Board *board;
+    int attacker;
+    std::unordered_map<unsigned long long, int> table;
+    std::vector<ProofNode> nodes;
+    std::vector<ProofLink> links;
+    std::vector<int> squares, moves, remaining;
+    long long max_nodes;
+    size_t max_memory;
+
+    size_t memoryUsed()
+    {
+        // an unordered_map node holds the pair plus a next pointer and a bucket slot
+        return nodes.size() * sizeof(ProofNode) + links.size() * sizeof(ProofLink) +
+               table.size() * (sizeof(std::pair<unsigned long long, int>) + 2 * sizeof(void *));
+    }
+
+    int getNode(unsigned long long key, bool attacker_turn)
+    {
+        auto found = table.find(key);
+        if (found != table.end())
+            return found->second;
+        ProofNode node;
+        node.pn = 1;
+        node.dn = 1;
+        node.attacker_turn = attacker_turn;
+        node.expanded = false;
+        node.first_child = 0;
+        node.num_children = 0;
+        node.move = -1;
+        nodes.push_back(node);
+        table[key] = (int)nodes.size() - 1;
+        return (int)nodes.size() - 1;
+    }
+
+    void setResult(int id, bool proven)
+    {
+        nodes[id].pn = proven ? 0 : PN_INF;
+        nodes[id].dn = proven ? PN_INF : 0;
+    }
+
+    // empty cells where a stone of -threat_color leaves threat_color without a five
+    // square, threats being its five squares now. Besides the squares themselves a
+    // stone past either end of a threatened line can stop it when blocked ends count
+    // (caro), and one such stone may stop two squares at once
+    void defences(int threat_color, const std::vector<int> &threats, std::vector<int> &out)
+    {
+        out.clear();
+        for (int square : threats)
+        {
+            out.push_back(square);
+            for (int axis = 0; axis < 4; ++axis)
+            {
+                for (int sign = -1; sign <= 1; sign += 2)
+                {
+                    int step = sign * axis_step[axis];
+                    int cell = square + step;
+                    while ((*board)[cell] == threat_color)
+                        cell += step;
+                    if ((*board)[cell] == 0)
+                        out.push_back(cell);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        size_t kept = 0;
+        for (int cell : out)
+        {
+            BoundingBox saved = board->bounds();
+            board->place(cell, -threat_color);
+            board->fiveSquares<Rule>(threat_color, remaining);
+            board->remove(cell, saved);
+            if (remaining.empty())
+                out[kept++] = cell;
+        }
+        out.resize(kept);
+    }
+
+    // generate the children of the current position, or decide it on the spot
+    void expand(int id)
+    {
+        bool attacker_turn = nodes[id].attacker_turn;
+        nodes[id].expanded = true;
+        int side = attacker_turn ? attacker : -attacker;
+        moves.clear();
+        if (attacker_turn)
+        {
+            board->fiveSquares<Rule>(attacker, squares);
+            if (!squares.empty())
+            {
+                nodes[id].move = squares[0];
+                setResult(id, true);
+                return;
+            }
+            // the defender's fours must be stopped, and the stopping stone must be a four too
+            board->fiveSquares<Rule>(-attacker, squares);
+            if (!squares.empty())
+            {
+                defences(-attacker, squares, moves);
+                moves.erase(std::remove_if(moves.begin(), moves.end(), [this](int move)
+                                           { return !board->makesFour<Rule>(move, attacker); }),
+                            moves.end());
+            }
+            else
+                board->fourMoves<Rule>(attacker, moves);
+        }
+        else
+        {
+            board->fiveSquares<Rule>(-attacker, squares);
+            if (!squares.empty())
+            {
+                setResult(id, false);
+                return;
+            }
+            // every stone that stops all the attacker's five squares, none is a win
+            board->fiveSquares<Rule>(attacker, squares);
+            if (squares.empty())
+            {
+                setResult(id, false);
+                return;
+            }
+            defences(attacker, squares, moves);
+            if (moves.empty())
+            {
+                setResult(id, true);
+                return;
+            }
+        }
+        if (moves.empty())
+        {
+            setResult(id, false);
+            return;
+        }
+
+        int first_child = (int)links.size();
+        for (int move : moves)
+        {
+            BoundingBox saved = board->bounds();
+            board->place(move, side);
+            ProofLink link;
+            link.move = move;
+            link.node = getNode(board->key(-side), !attacker_turn);
+            board->remove(move, saved);
+            links.push_back(link);
+        }
+        nodes[id].first_child = first_child;
+        nodes[id].num_children = (int)moves.size();
+        update(id);
+    }
+
+    // recompute the proof and disproof numbers from the children
+    void update(int id)
+    {
+        ProofNode &node = nodes[id];
+        if (!node.expanded || node.num_children == 0)
+            return;
+        unsigned best = PN_INF, sum = 0;
+        int best_move = -1;
+        for (int i = node.first_child; i < node.first_child + node.num_children; ++i)
+        {
+            const ProofNode &child = nodes[links[i].node];
+            unsigned minimized = node.attacker_turn ? child.pn : child.dn;
+            unsigned summed = node.attacker_turn ? child.dn : child.pn;
+            if (minimized < best)
+            {
+                best = minimized;
+                best_move = links[i].move;
+            }
+            sum = std::min(PN_INF, sum + summed);
+        }
+        if (node.attacker_turn)
+        {
+            node.pn = best;
+            node.dn = sum;
+            if (best == 0)
+                node.move = best_move;
+        }
+        else
+        {
+            node.pn = sum;
+            node.dn = best;
+        }
+    }
+
+    // child on the most proving path
+    int selectChild(int id)
+    {
+        const ProofNode &node = nodes[id];
+        int best = node.first_child;
+        for (int i = node.first_child; i < node.first_child + node.num_children; ++i)
+        {
+            const ProofNode &child = nodes[links[i].node];
+            const ProofNode &current = nodes[links[best].node];
+            if (node.attacker_turn ? child.pn < current.pn : child.dn < current.dn)
+                best = i;
+        }
+        return best;
+    }
+
+public:
+    ProofNumberSolver(long long in_max_nodes = SOLVER_NODES, size_t in_max_memory = SOLVER_MEMORY)
+    {
+        max_nodes = in_max_nodes;
+        max_memory = in_max_memory;
+        board = NULL;
+        attacker = 1;
+    }
+
+    // try to prove that in_attacker, to move, wins by continuous fours.
+    // The board is restored before returning; move is the winning board index.
+    // abort(abort_arg, positions created so far) is polled every SOLVER_POLL
+    // iterations, the solve gives up (UNKNOWN) as soon as it returns true
+    int solve(Board &in_board, int in_attacker, int &move, bool (*abort)(void *, long long) = NULL, void *abort_arg = NULL)
+    {
+        board = &in_board;
+        attacker = in_attacker;
+        table.clear();
+        nodes.clear();
+        links.clear();
+        int root = getNode(board->key(attacker), true);
+
+        struct Step
+        {
+            int move;
+            BoundingBox saved;
+        };
+        std::vector<Step> path;
+        std::vector<int> path_nodes;
+        // with transpositions a path can end on a node that is already decided,
+        // so iterations are capped as well as created nodes
+        for (long long iteration = 0; nodes[root].pn != 0 && nodes[root].dn != 0; ++iteration)
+        {
+            if ((long long)nodes.size() >= max_nodes || iteration >= 4 * max_nodes || memoryUsed() >= max_memory)
+                break;
+            if (abort && iteration % SOLVER_POLL == 0 && abort(abort_arg, (long long)nodes.size()))
+                break;
+            // walk down the most proving path
+            int id = root;
+            int side = attacker;
+            path.clear();
+            path_nodes.clear();
+            while (nodes[id].expanded && nodes[id].num_children > 0 && nodes[id].pn != 0 && nodes[id].dn != 0)
+            {
+                int link = selectChild(id);
+                Step step;
+                step.move = links[link].move;
+                step.saved = board->bounds();
+                board->place(step.move, side);
+                path.push_back(step);
+                path_nodes.push_back(id);
+                id = links[link].node;
+                side = -side;
+            }
+            if (!nodes[id].expanded)
+                expand(id);
+            // back up along the same path
+            while (!path.empty())
+            {
+                board->remove(path.back().move, path.back().saved);
+                path.pop_back();
+                update(path_nodes.back());
+                path_nodes.pop_back();
+            }
+        }
+        move = nodes[root].move;
+        return nodes[root].pn == 0 ? SOLVER_WIN : SOLVER_UNKNOWN;
+    }
+
+    // number of positions created by the last solve
+    long long nodeCount()
+    {
+        return (long long)nodes.size();
+    }
+
+    // every attacker position proven by the last solve, with its winning board index
+    void proven(std::vector<std::pair<unsigned long long, int>> &out)
+    {
+        out.clear();
+        for (auto &item : table)
+        {
+            const ProofNode &node = nodes[item.second];
+            if (node.attacker_turn && node.pn == 0 && node.move >= 0)
+                out.push_back(std::make_pair(item.first, node.move));
+        }
+    }
+};
+
+#endif // PN_SOLVER
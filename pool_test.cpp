@@ -0,0 +1,125 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdlib.h>
+
+#include "config.h"
+#include "custom_bot.h"
+#include "search_pool.h"
+#include "rng.h"
+
+using namespace std;
+
+// checks SearchPool (search_pool.h) against plain sequential searches
+// usage: pool_test [-searches N] [-threads N] [-in-flight N] [-nodes N] [-slice N] [-seed S]
+// Every search is deterministic (Gomoku::setDeterministic) with a node budget, once
+// on one engine in order and once submitted to a pool whose searches yield every
+// -slice nodes, at most -in-flight at a time on engines that are reused. Best
+// move, score, depth and node count must be the same; the exit code is 1 otherwise.
+
+const int MAX_STONES = 60;
+
+struct Search{
+    int board[HEIGHT][WIDTH];
+    int color;
+    SearchInfo expected;
+};
+
+void random_position(int board[][WIDTH], int &color, Rng &rng);
+
+int main(int argc, char **argv){
+    int num_searches = 300;
+    int num_threads = 4;
+    int in_flight = 64;
+    long long slice = POOL_SLICE_NODES;
+    SearchLimits limits;
+    limits.depth = MAX_DEPTH;
+    limits.nodes = 3000;
+    unsigned long long seed = 1;
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(i + 1 >= argc){
+            cout<<"usage: pool_test [-searches N] [-threads N] [-in-flight N] [-nodes N] [-slice N] [-seed S]"<<endl;
+            return 1;
+        }
+        if(arg == "-searches") num_searches = atoi(argv[++i]);
+        else if(arg == "-threads") num_threads = atoi(argv[++i]);
+        else if(arg == "-in-flight") in_flight = atoi(argv[++i]);
+        else if(arg == "-nodes") limits.nodes = atoll(argv[++i]);
+        else if(arg == "-slice") slice = atoll(argv[++i]);
+        else if(arg == "-seed") seed = strtoull(argv[++i], NULL, 10);
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+    if(in_flight < 1) in_flight = 1;
+
+    Rng rng(seed);
+    vector<unique_ptr<Search>> searches;
+    unique_ptr<Gomoku> sequential(new Gomoku());
+    sequential->setDeterministic(true);
+    for(int i = 0; i < num_searches; i++){
+        unique_ptr<Search> search(new Search());
+        random_position(search->board, search->color, rng);
+        search->expected = sequential->search(search->board, search->color, limits);
+        searches.push_back(move(search));
+    }
+
+    // the engines are reused round robin, a slot waits for its previous search first
+    long long mismatches = 0;
+    vector<unique_ptr<Gomoku>> engines;
+    vector<shared_ptr<PooledSearch>> running(in_flight);
+    vector<int> owner(in_flight, -1);
+    for(int i = 0; i < in_flight; i++){
+        engines.push_back(unique_ptr<Gomoku>(new Gomoku()));
+        engines.back()->setDeterministic(true);
+    }
+    auto compare = [&](int slot){
+        if(owner[slot] < 0) return;
+        SearchInfo actual = running[slot]->wait();
+        const SearchInfo &expected = searches[owner[slot]]->expected;
+        if(actual.best.x != expected.best.x || actual.best.y != expected.best.y || actual.score != expected.score ||
+           actual.depth != expected.depth || actual.nodes != expected.nodes){
+            cout<<"search "<<owner[slot]<<": pool "<<actual.best.x<<","<<actual.best.y<<" depth "<<actual.depth
+                <<" nodes "<<actual.nodes<<", sequential "<<expected.best.x<<","<<expected.best.y
+                <<" depth "<<expected.depth<<" nodes "<<expected.nodes<<endl;
+            mismatches++;
+        }
+        owner[slot] = -1;
+    };
+    {
+        SearchPool pool(num_threads, slice);
+        for(int i = 0; i < num_searches; i++){
+            int slot = i % in_flight;
+            compare(slot);
+            running[slot] = pool.submit(*engines[slot], searches[i]->board, searches[i]->color, limits);
+            owner[slot] = i;
+        }
+        for(int slot = 0; slot < in_flight; slot++) compare(slot);
+    }
+    cout<<num_searches<<" searches, "<<mismatches<<" mismatches"<<endl;
+    return mismatches ? 1 : 0;
+}
+
+// stones around a random center, colors alternate so the side to move is the one with fewer stones
+void random_position(int board[][WIDTH], int &color, Rng &rng){
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            board[i][j] = 0;
+        }
+    }
+    int stones = rng.below(MAX_STONES + 1);
+    int radius = 4 + rng.below(6);
+    int center_x = radius + rng.below(HEIGHT - 2 * radius), center_y = radius + rng.below(WIDTH - 2 * radius);
+    color = 1;
+    for(int placed = 0; placed < stones; ){
+        int x = center_x - radius + rng.below(2 * radius + 1);
+        int y = center_y - radius + rng.below(2 * radius + 1);
+        if(board[x][y] != 0) continue;
+        board[x][y] = color;
+        color = -color;
+        placed++;
+    }
+}
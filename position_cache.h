@@ -0,0 +1,312 @@
+#ifndef POSITION_CACHE
+#define POSITION_CACHE
+
+#include <atomic>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "board.h"
+
+// Position cache kept in a memory mapped file, shared by every process that
+// opens the same path and kept across restarts.
+// Positions are keyed by their canonical Zobrist key: the smallest key over the
+// four symmetries of the rectangle (identity, row flip, column flip, both), so
+// mirrored positions share one entry. Moves are stored in canonical coordinates.
+//
+// Every slot is two 64 bit words, check = key ^ data and data. Readers take no
+// lock: a slot torn by a concurrent writer fails the check and reads as a miss.
+// Writers choose the slot to replace by depth and age; an age counter in the
+// file header is bumped by every open, and every CACHE_COMPACT_EVERY opens the
+// entries older than CACHE_MAX_AGE are cleared.
+// Scores and proofs depend on the win rule (rules.h), so a file belongs to the
+// rule it was created for and open refuses it for any other one.
+
+const unsigned CACHE_MAGIC = 0x32435047; // "GPC2", files of "GPC1" had no rule and are reset
+const int CACHE_BUCKET = 4;              // slots per bucket, one cache line
+const unsigned CACHE_MAX_AGE = 64;       // opens an unused entry survives compaction
+const unsigned CACHE_COMPACT_EVERY = 16;
+const int CACHE_PROVEN_DEPTH = 255;      // depth stored for solver results
+const size_t CACHE_HEADER_SIZE = 64;     // the slots start on a cache line
+
+struct CacheEntry
+{
+    int depth;  // CACHE_PROVEN_DEPTH for proven results
+    int bound;  // BOUND_* of transposition.h
+    double score; // getBoardEvaluation units, white's point of view
+    int move;   // row * WIDTH + col in the probed position, -1 when unknown
+};
+
+struct CacheHeader
+{
+    unsigned magic;
+    int height, width;
+    int rule;            // Rule::id of the engines sharing the file
+    unsigned generation; // bumped by every open
+    unsigned long long buckets;
+};
+
+struct CacheSlot
+{
+    std::atomic<unsigned long long> check;
+    std::atomic<unsigned long long> data;
+};
+
+// data: score (float bits) 32 | move 12 | bound 2 | depth 8 | generation 10
+const unsigned CACHE_GENERATION_MASK = (1 << 10) - 1;
+const unsigned CACHE_NO_MOVE = (1 << 12) - 1;
+
+// cell row * WIDTH + col seen through symmetry (bit 0 flips rows, bit 1 flips columns)
+inline int symmetricCell(int cell, int symmetry)
+{
+    int row = cell / WIDTH, col = cell % WIDTH;
+    if (symmetry & 1)
+        row = HEIGHT - 1 - row;
+    if (symmetry & 2)
+        col = WIDTH - 1 - col;
+    return row * WIDTH + col;
+}
+
+// smallest key over the symmetries, side is the color to move
+inline unsigned long long canonicalKey(const Board &board, int side, int &symmetry)
+{
+    unsigned long long keys[4] = {0, 0, 0, 0};
+    const BoundingBox &box = board.bounds();
+    for (int row = box.top; row <= box.bottom; ++row)
+        for (int col = box.left; col <= box.right; ++col)
+        {
+            int value = board[toIndex(row, col)];
+            if (!isStone(value))
+                continue;
+            int flipped_row = HEIGHT - 1 - row, flipped_col = WIDTH - 1 - col;
+            keys[0] ^= zobrist.key(toIndex(row, col), value);
+            keys[1] ^= zobrist.key(toIndex(flipped_row, col), value);
+            keys[2] ^= zobrist.key(toIndex(row, flipped_col), value);
+            keys[3] ^= zobrist.key(toIndex(flipped_row, flipped_col), value);
+        }
+    symmetry = 0;
+    for (int i = 1; i < 4; ++i)
+        if (keys[i] < keys[symmetry])
+            symmetry = i;
+    return side == -1 ? keys[symmetry] ^ zobrist.side : keys[symmetry];
+}
+
+class PositionCache
+{
+private:
+    CacheHeader *header;
+    CacheSlot *slots;
+    size_t mapped_size;
+    unsigned generation;
+    int fd;
+
+    static unsigned long long pack(const CacheEntry &entry, unsigned generation)
+    {
+        float score = (float)entry.score;
+        unsigned bits;
+        memcpy(&bits, &score, sizeof(bits));
+        unsigned move = entry.move < 0 ? CACHE_NO_MOVE : (unsigned)entry.move;
+        unsigned depth = entry.depth < 0 ? 0 : (entry.depth > CACHE_PROVEN_DEPTH ? CACHE_PROVEN_DEPTH : entry.depth);
+        return (unsigned long long)bits << 32 | (unsigned long long)move << 20 | (unsigned long long)(entry.bound & 3) << 18 |
+               (unsigned long long)depth << 10 | (generation & CACHE_GENERATION_MASK);
+    }
+
+    static CacheEntry unpack(unsigned long long data)
+    {
+        CacheEntry entry;
+        unsigned bits = (unsigned)(data >> 32);
+        float score;
+        memcpy(&score, &bits, sizeof(score));
+        entry.score = score;
+        unsigned move = (data >> 20) & CACHE_NO_MOVE;
+        entry.move = move == CACHE_NO_MOVE ? -1 : (int)move;
+        entry.bound = (int)((data >> 18) & 3);
+        entry.depth = (int)((data >> 10) & 0xff);
+        return entry;
+    }
+
+    unsigned age(unsigned long long data) const
+    {
+        return (generation - (unsigned)data) & CACHE_GENERATION_MASK;
+    }
+
+    CacheSlot *bucket(unsigned long long key) const
+    {
+        return slots + (key & (header->buckets - 1)) * CACHE_BUCKET;
+    }
+
+public:
+    PositionCache()
+    {
+        header = NULL;
+        slots = NULL;
+        mapped_size = 0;
+        generation = 0;
+        fd = -1;
+    }
+
+    ~PositionCache()
+    {
+        close();
+    }
+
+    // map the cache file, creating or resetting it when the layout does not match.
+    // in_rule is the Rule::id of the engines using it, false for a file of another
+    // rule. in_entries is rounded down to a power of two number of buckets, every
+    // process sharing the file must use the same value
+    bool open(const char *path, int in_rule, size_t in_entries = CACHE_ENTRIES)
+    {
+        close();
+        unsigned long long buckets = 1;
+        while (buckets * 2 * CACHE_BUCKET <= in_entries)
+            buckets *= 2;
+        size_t size = CACHE_HEADER_SIZE + buckets * CACHE_BUCKET * sizeof(CacheSlot);
+
+        fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            return false;
+        // the lock only covers setting the file up, lookups and stores never take it
+        flock(fd, LOCK_EX);
+        CacheHeader current;
+        struct stat info;
+        bool valid = fstat(fd, &info) == 0 && (size_t)info.st_size == size &&
+                     pread(fd, &current, sizeof(current), 0) == (ssize_t)sizeof(current) &&
+                     current.magic == CACHE_MAGIC && current.height == HEIGHT && current.width == WIDTH &&
+                     current.buckets == buckets;
+        if ((valid && current.rule != in_rule) || (!valid && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)))
+        {
+            flock(fd, LOCK_UN);
+            close();
+            return false;
+        }
+        void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            flock(fd, LOCK_UN);
+            close();
+            return false;
+        }
+        mapped_size = size;
+        header = (CacheHeader *)mapped;
+        slots = (CacheSlot *)((char *)mapped + CACHE_HEADER_SIZE);
+        if (!valid)
+        {
+            header->height = HEIGHT;
+            header->width = WIDTH;
+            header->rule = in_rule;
+            header->buckets = buckets;
+            header->generation = 0;
+            header->magic = CACHE_MAGIC;
+        }
+        generation = ++header->generation;
+        if (generation % CACHE_COMPACT_EVERY == 0)
+            compact();
+        flock(fd, LOCK_UN);
+        return true;
+    }
+
+    void close()
+    {
+        if (header)
+            munmap(header, mapped_size);
+        if (fd >= 0)
+            ::close(fd);
+        header = NULL;
+        slots = NULL;
+        mapped_size = 0;
+        fd = -1;
+    }
+
+    bool isOpen() const
+    {
+        return header != NULL;
+    }
+
+    // Rule::id of the open file
+    int rule() const
+    {
+        return header ? header->rule : -1;
+    }
+
+    // look up the position, the move is mapped back from canonical coordinates
+    bool probe(const Board &board, int side, CacheEntry &entry) const
+    {
+        if (!header)
+            return false;
+        int symmetry;
+        unsigned long long key = canonicalKey(board, side, symmetry);
+        CacheSlot *slot = bucket(key);
+        for (int i = 0; i < CACHE_BUCKET; ++i)
+        {
+            unsigned long long data = slot[i].data.load(std::memory_order_relaxed);
+            unsigned long long check = slot[i].check.load(std::memory_order_relaxed);
+            if ((check ^ data) != key || data == 0)
+                continue;
+            entry = unpack(data);
+            if (entry.move >= 0)
+                entry.move = symmetricCell(entry.move, symmetry);
+            return true;
+        }
+        return false;
+    }
+
+    // keep the deeper result for the same position, otherwise replace the slot
+    // with the least depth left after subtracting its age
+    void store(const Board &board, int side, const CacheEntry &entry)
+    {
+        if (!header)
+            return;
+        int symmetry;
+        unsigned long long key = canonicalKey(board, side, symmetry);
+        CacheEntry canonical = entry;
+        if (canonical.depth > CACHE_PROVEN_DEPTH)
+            canonical.depth = CACHE_PROVEN_DEPTH;
+        if (canonical.move >= 0)
+            canonical.move = symmetricCell(canonical.move, symmetry);
+        CacheSlot *slot = bucket(key);
+        int victim = 0, victim_value = 1 << 30;
+        for (int i = 0; i < CACHE_BUCKET; ++i)
+        {
+            unsigned long long data = slot[i].data.load(std::memory_order_relaxed);
+            unsigned long long check = slot[i].check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && data != 0)
+            {
+                if (unpack(data).depth > canonical.depth)
+                    return;
+                victim = i;
+                break;
+            }
+            int value = data == 0 ? -(1 << 30) : unpack(data).depth - (int)age(data);
+            if (value < victim_value)
+            {
+                victim = i;
+                victim_value = value;
+            }
+        }
+        unsigned long long data = pack(canonical, generation);
+        slot[victim].data.store(data, std::memory_order_relaxed);
+        slot[victim].check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    // clear the entries not refreshed during the last CACHE_MAX_AGE opens
+    void compact()
+    {
+        if (!header)
+            return;
+        unsigned long long total = header->buckets * CACHE_BUCKET;
+        for (unsigned long long i = 0; i < total; ++i)
+        {
+            unsigned long long data = slots[i].data.load(std::memory_order_relaxed);
+            if (data != 0 && age(data) > CACHE_MAX_AGE)
+            {
+                slots[i].check.store(0, std::memory_order_relaxed);
+                slots[i].data.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif // POSITION_CACHE
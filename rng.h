@@ -0,0 +1,47 @@
+#ifndef RNG
+#define RNG
+
+#include <chrono>
+#include "config.h"
+
+// Small random generator owned by its user (splitmix64).
+// A seed, 0 included, fixes the whole sequence, on every platform and independently
+// of other generators, so it is safe to give one to every thread or engine.
+// fromClock gives a new sequence on every run.
+class Rng
+{
+private:
+    unsigned long long state;
+
+public:
+    Rng(unsigned long long in_seed = RANDOM_SEED)
+    {
+        seed(in_seed);
+    }
+
+    void seed(unsigned long long in_seed)
+    {
+        state = in_seed;
+    }
+
+    static Rng fromClock()
+    {
+        return Rng((unsigned long long)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    }
+
+    unsigned long long next()
+    {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // uniform in [0, n), n > 0
+    int below(int n)
+    {
+        return (int)(((next() >> 32) * (unsigned long long)n) >> 32);
+    }
+};
+
+#endif // RNG
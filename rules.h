@@ -0,0 +1,45 @@
+#ifndef RULES
+#define RULES
+
+// Win rules, used as the template parameter of GomokuEngine, ProofNumberSolver
+// and the threat queries of Board. A rule only decides whether a line of
+// length stones of one color, with blocked (0..2) ends closed by the other
+// color or the edge of the board, is a win. Everything is constexpr so each
+// rule gets its own specialized hot loops and pattern tables.
+
+// rule ids, also stored in game records (game_record.h)
+const int RULE_CARO = 0;
+const int RULE_FREESTYLE = 1;
+const int RULE_EXACT_FIVE = 2;
+
+// five or more in a row, unless both ends are closed
+struct CaroRule
+{
+    static constexpr int id = RULE_CARO;
+    static constexpr bool wins(int length, int blocked)
+    {
+        return length >= 5 && blocked < 2;
+    }
+};
+
+// five or more in a row
+struct FreestyleRule
+{
+    static constexpr int id = RULE_FREESTYLE;
+    static constexpr bool wins(int length, int /*blocked*/)
+    {
+        return length >= 5;
+    }
+};
+
+// exactly five in a row, an overline does not win
+struct ExactFiveRule
+{
+    static constexpr int id = RULE_EXACT_FIVE;
+    static constexpr bool wins(int length, int /*blocked*/)
+    {
+        return length == 5;
+    }
+};
+
+#endif // RULES
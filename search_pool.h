@@ -0,0 +1,230 @@
+#ifndef SEARCH_POOL
+#define SEARCH_POOL
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "config.h"
+#include "custom_bot.h"
+
+// Many small searches multiplexed on a few threads.
+// Every search runs on its own small stack (ucontext) and gives its thread back
+// every POOL_SLICE_NODES nodes through Gomoku::setYield, the threads take the
+// waiting searches round robin. A search only holds a stack while it runs, the
+// pages of the stack are only backed by memory once they are touched.
+
+// one submitted search, owned by the submitter through a shared_ptr
+class PooledSearch
+{
+private:
+    friend class SearchPool;
+
+    Gomoku *engine;
+    std::vector<int> board; // private copy, the caller may keep changing its board
+    int color;
+    SearchLimits limits;
+    std::vector<RootMove> *moves; // scored root moves, NULL when not wanted
+
+    ucontext_t context;
+    ucontext_t *caller; // context of the thread running the current slice
+    void *stack;
+    size_t stack_size;
+
+    std::mutex lock;
+    std::condition_variable finished;
+    bool done_flag;
+    SearchInfo result;
+
+    // entry point of the search context, the pointer is split into two ints for makecontext
+    static void run(unsigned high, unsigned low)
+    {
+        PooledSearch *search = (PooledSearch *)(((uintptr_t)high << 16 << 16) | (uintptr_t)low);
+        SearchInfo info = search->engine->search((int(*)[WIDTH])search->board.data(), search->color, search->limits, search->moves);
+        search->engine->setYield(NULL, NULL, 0);
+        {
+            std::lock_guard<std::mutex> guard(search->lock);
+            search->result = info;
+            search->done_flag = true;
+        }
+        search->finished.notify_all();
+        // uc_link is fixed by makecontext, but the last slice may run on another thread
+        setcontext(search->caller);
+    }
+
+    // Gomoku yield hook: give the thread back, the search continues on the next resume
+    static void yield(void *arg)
+    {
+        PooledSearch *search = (PooledSearch *)arg;
+        swapcontext(&search->context, search->caller);
+    }
+
+public:
+    PooledSearch()
+    {
+        engine = NULL;
+        color = 1;
+        moves = NULL;
+        caller = NULL;
+        stack = NULL;
+        stack_size = 0;
+        done_flag = false;
+    }
+
+    ~PooledSearch()
+    {
+        if (stack)
+            munmap(stack, stack_size);
+    }
+
+    bool done()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return done_flag;
+    }
+
+    // best move / score / depth of the deepest completed iteration so far
+    SearchInfo poll()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return done_flag ? result : engine->currentInfo();
+    }
+
+    // block until the search has finished and return its result
+    SearchInfo wait()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this]
+                      { return done_flag; });
+        return result;
+    }
+
+    // abort the search, it finishes with the best move found so far on its next slice
+    void stop()
+    {
+        engine->stop();
+    }
+};
+
+class SearchPool
+{
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::shared_ptr<PooledSearch>> ready;
+    std::mutex lock;
+    std::condition_variable not_empty;
+    bool closing;
+    long long slice_nodes;
+    size_t stack_size;
+
+    std::shared_ptr<PooledSearch> pop()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        not_empty.wait(guard, [this]
+                       { return !ready.empty() || closing; });
+        if (ready.empty())
+            return NULL;
+        std::shared_ptr<PooledSearch> search = ready.front();
+        ready.pop_front();
+        return search;
+    }
+
+    // first slice of a search: map its stack and build its context
+    bool prepare(PooledSearch &search)
+    {
+        void *stack = mmap(NULL, stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (stack == MAP_FAILED)
+            return false;
+        search.stack = stack;
+        search.stack_size = stack_size;
+        getcontext(&search.context);
+        search.context.uc_stack.ss_sp = stack;
+        search.context.uc_stack.ss_size = stack_size;
+        search.context.uc_link = NULL;
+        uintptr_t address = (uintptr_t)&search;
+        makecontext(&search.context, (void (*)())PooledSearch::run, 2, (unsigned)(address >> 16 >> 16), (unsigned)address);
+        search.engine->setYield(PooledSearch::yield, &search, slice_nodes);
+        return true;
+    }
+
+    void worker()
+    {
+        ucontext_t home;
+        std::shared_ptr<PooledSearch> search;
+        while ((search = pop()) != NULL)
+        {
+            if (!search->stack && !prepare(*search))
+            {
+                // no memory for a stack: run it here without yielding
+                SearchInfo info = search->engine->search((int(*)[WIDTH])search->board.data(), search->color, search->limits, search->moves);
+                std::lock_guard<std::mutex> guard(search->lock);
+                search->result = info;
+                search->done_flag = true;
+                search->finished.notify_all();
+                continue;
+            }
+            search->caller = &home;
+            swapcontext(&home, &search->context);
+            if (search->done())
+            {
+                munmap(search->stack, search->stack_size);
+                search->stack = NULL;
+                continue;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            ready.push_back(search);
+            not_empty.notify_one();
+        }
+    }
+
+public:
+    // in_slice_nodes: nodes a search runs before the next waiting one gets the thread
+    SearchPool(int num_threads = (int)std::thread::hardware_concurrency(), long long in_slice_nodes = POOL_SLICE_NODES,
+               size_t in_stack_size = POOL_STACK_SIZE)
+    {
+        closing = false;
+        slice_nodes = in_slice_nodes;
+        stack_size = in_stack_size;
+        if (num_threads < 1)
+            num_threads = 1;
+        for (int i = 0; i < num_threads; ++i)
+            threads.push_back(std::thread(&SearchPool::worker, this));
+    }
+
+    // finishes every submitted search first
+    ~SearchPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closing = true;
+            not_empty.notify_all();
+        }
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    // queue a search of in_board for in_color, moves as in Gomoku::search.
+    // The engine (and moves) must outlive the search and must not be used elsewhere until it is done
+    std::shared_ptr<PooledSearch> submit(Gomoku &engine, int in_board[][WIDTH], int in_color, const SearchLimits &limits,
+                                         std::vector<RootMove> *moves = NULL)
+    {
+        std::shared_ptr<PooledSearch> search(new PooledSearch());
+        search->engine = &engine;
+        search->board.assign(&in_board[0][0], &in_board[0][0] + HEIGHT * WIDTH);
+        search->color = in_color;
+        search->limits = limits;
+        search->moves = moves;
+        engine.clearStop();
+        std::lock_guard<std::mutex> guard(lock);
+        ready.push_back(search);
+        not_empty.notify_one();
+        return search;
+    }
+};
+
+#endif // SEARCH_POOL
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <stdlib.h>
+
+#include "config.h"
+#include "board.h"
+#include "rules.h"
+#include "pn_solver.h"
+#include "rng.h"
+
+using namespace std;
+
+// checks every win of the proof-number solver (pn_solver.h) by brute force, once per win rule
+// usage: solver_test [-positions N] [-nodes N] [-seed S]
+// A proof is replayed: the attacker plays the solver's move, the defender then tries
+// every empty cell of the board, and the attacker must win the resulting position
+// again (re-solved) until Board::winner sees its line. A defender reply that wins,
+// fills the board or escapes the solver is a false proof; the exit code is 1.
+// Proofs whose replay takes more than MAX_REPLAYS solves are counted as unchecked.
+// A position on row 10, O . X X X . . O, is known: a win for X without blocked ends
+// only. Random positions are dense clusters where the attacker has a four to play.
+
+const int MAX_PLIES = 40;   // attacker moves a replayed proof may take
+const int MIN_STONES = 16;
+const int MAX_STONES = 70;
+const long long MAX_REPLAYS = 3000; // attacker positions re-solved per proof
+
+struct Totals{
+    long long positions;
+    long long proofs;
+    long long false_proofs;
+    long long unchecked;
+};
+
+long long solver_nodes = 2000;
+long long replays;
+unordered_set<unsigned long long> verified; // attacker to move positions already replayed to a win
+
+template <class Rule> long long run_rule(const char *name, bool blocked_ends, int num_positions, unsigned long long seed);
+void random_position(int board[][WIDTH], Rng &rng);
+template <class Rule> bool verify(Board &board, int attacker, int plies, string &line);
+
+int main(int argc, char **argv){
+    int num_positions = 300;
+    unsigned long long seed = 1;
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(i + 1 >= argc){
+            cout<<"usage: solver_test [-positions N] [-nodes N] [-seed S]"<<endl;
+            return 1;
+        }
+        if(arg == "-positions") num_positions = atoi(argv[++i]);
+        else if(arg == "-nodes") solver_nodes = atoll(argv[++i]);
+        else if(arg == "-seed") seed = strtoull(argv[++i], NULL, 10);
+        else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+    long long failures = 0;
+    failures += run_rule<CaroRule>("caro", true, num_positions, seed);
+    failures += run_rule<FreestyleRule>("freestyle", false, num_positions, seed);
+    failures += run_rule<ExactFiveRule>("exact", false, num_positions, seed);
+    return failures ? 1 : 0;
+}
+
+// every rule sees the same positions
+template <class Rule>
+long long run_rule(const char *name, bool blocked_ends, int num_positions, unsigned long long seed){
+    Rng rng(seed);
+    Totals totals = {};
+    static Board board;
+    static int plain[HEIGHT][WIDTH];
+    long long failures = 0;
+    ProofNumberSolver<Rule> solver(solver_nodes);
+    int move;
+
+    // the known position: only a win when a line closed at both ends still counts
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            plain[i][j] = 0;
+        }
+    }
+    plain[10][8] = plain[10][15] = -1;
+    plain[10][10] = plain[10][11] = plain[10][12] = 1;
+    board.load(plain);
+    bool won = solver.solve(board, 1, move) == SOLVER_WIN;
+    if(won == blocked_ends){
+        cout<<name<<": O . X X X . . O solved as "<<(won ? "a win" : "no win")<<endl;
+        failures++;
+    }
+
+    for(int i = 0; i < num_positions; i++){
+        random_position(plain, rng);
+        board.load(plain);
+        vector<int> fours;
+        board.fourMoves<Rule>(1, fours);
+        if(board.winner<Rule>() != 0 || fours.empty()) continue;
+        totals.positions++;
+        if(solver.solve(board, 1, move) != SOLVER_WIN) continue;
+        totals.proofs++;
+        string line;
+        replays = 0;
+        verified.clear();
+        if(verify<Rule>(board, 1, MAX_PLIES, line)) continue;
+        if(replays > MAX_REPLAYS) totals.unchecked++;
+        else {
+            cout<<name<<": position "<<i<<" false proof, refuted by"<<line<<endl;
+            totals.false_proofs++;
+        }
+    }
+    cout<<name<<": "<<totals.positions<<" positions, "<<totals.proofs<<" proofs, "
+        <<totals.false_proofs<<" false proofs, "<<totals.unchecked<<" unchecked"<<endl;
+    return failures + totals.false_proofs;
+}
+
+// a cluster of stones, as many of each color, the next one for 1
+void random_position(int board[][WIDTH], Rng &rng){
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            board[i][j] = 0;
+        }
+    }
+    int radius = 3 + rng.below(4);
+    int stones = (MIN_STONES + rng.below(MAX_STONES - MIN_STONES + 1)) & ~1;
+    stones = min(stones, (2 * radius + 1) * (2 * radius + 1) * 2 / 3 & ~1);
+    int center_x = radius + rng.below(HEIGHT - 2 * radius), center_y = radius + rng.below(WIDTH - 2 * radius);
+    int color = 1;
+    for(int placed = 0; placed < stones; ){
+        int x = center_x - radius + rng.below(2 * radius + 1);
+        int y = center_y - radius + rng.below(2 * radius + 1);
+        if(board[x][y] != 0) continue;
+        board[x][y] = color;
+        color = -color;
+        placed++;
+    }
+}
+
+// attacker to move wins: a line on the board, or a solver move that every
+// defender reply loses to. line gets the moves of a refutation
+template <class Rule>
+bool verify(Board &board, int attacker, int plies, string &line){
+    vector<int> squares;
+    board.fiveSquares<Rule>(attacker, squares);
+    if(!squares.empty()){
+        BoundingBox saved = board.bounds();
+        board.place(squares[0], attacker);
+        bool won = board.winner<Rule>() == attacker;
+        board.remove(squares[0], saved);
+        if(!won) line = " five square " + to_string(indexRow(squares[0])) + "," + to_string(indexCol(squares[0]));
+        return won;
+    }
+    if(verified.count(board.key(attacker))) return true;
+    if(++replays > MAX_REPLAYS) return false;
+    ProofNumberSolver<Rule> solver(solver_nodes);
+    int move;
+    if(plies == 0 || solver.solve(board, attacker, move) != SOLVER_WIN){
+        line = " (no win found)";
+        return false;
+    }
+    BoundingBox saved = board.bounds();
+    board.place(move, attacker);
+    bool ok = true;
+    for(int row = 0; row < HEIGHT && ok; row++){
+        for(int col = 0; col < WIDTH && ok; col++){
+            int reply = toIndex(row, col);
+            if(board[reply] != 0) continue;
+            BoundingBox before = board.bounds();
+            board.place(reply, -attacker);
+            ok = board.winner<Rule>() != -attacker && board.stones() < HEIGHT * WIDTH &&
+                 verify<Rule>(board, attacker, plies - 1, line);
+            board.remove(reply, before);
+            if(!ok) line = " " + to_string(row) + "," + to_string(col) + line;
+        }
+    }
+    board.remove(move, saved);
+    if(ok) verified.insert(board.key(attacker));
+    if(!ok) line = " " + to_string(indexRow(move)) + "," + to_string(indexCol(move)) + line;
+    return ok;
+}
@@ -0,0 +1,137 @@
+#ifndef TIME_MANAGER
+#define TIME_MANAGER
+
+#include <chrono>
+#include "config.h"
+#include "board.h"
+
+// Budget of one move out of a game clock: the time left to the side to move
+// and the increment it gets back after every move.
+// The search asks it after every completed iteration whether to go one deeper.
+// The soft budget is the usual time of a move: it is stretched in critical
+// positions (threats on the board) and every time the best move changes, and
+// shrunk while the best move stays the same. A forced or decided move stops at
+// once. The hard budget is the deadline of the running iteration; an iteration
+// that can't finish before it is not started.
+
+const int TIME_MOVES_TO_GO = 30;      // moves the remaining time is spread over when the game gives none
+const int TIME_MARGIN_MS = 30;        // kept back on every move for the overhead around the search
+const double TIME_HARD_RATIO = 4;     // hard budget in soft budgets
+const double TIME_MAX_SHARE = 0.3;    // the hard budget never takes more of the remaining time
+const double TIME_CRITICAL = 1.5;     // soft budget factor in positions with threats
+const double TIME_UNSTABLE = 1.4;     // soft budget factor for every change of the best move
+const double TIME_STABLE = 0.8;       // soft budget factor for every iteration past TIME_STABLE_ITERATIONS
+const int TIME_STABLE_ITERATIONS = 2; // iterations with the same best move before the budget shrinks
+const double TIME_MIN_SCALE = 0.4;    // the soft budget shrinks at most to this share
+const double TIME_BRANCHING = 3;      // an iteration takes about this many times the previous one
+
+class TimeManager
+{
+private:
+    long long remaining_ms;
+    long long increment_ms;
+    int moves_to_go;
+
+    std::chrono::steady_clock::time_point start;
+    long long soft_ms;
+    long long hard_ms;
+    double scale;             // applied to soft_ms, changed by the best move stability
+    Point last_best;
+    int stable_iterations;
+    long long last_iteration_ms; // elapsed time when the previous iteration completed
+    long long iteration_ms;      // duration of the last completed iteration
+
+public:
+    TimeManager()
+    {
+        remaining_ms = 0;
+        increment_ms = 0;
+        moves_to_go = 0;
+        soft_ms = hard_ms = 0;
+        scale = 1;
+        last_best = Point(-1, -1);
+        stable_iterations = 0;
+        last_iteration_ms = iteration_ms = 0;
+        start = std::chrono::steady_clock::now();
+    }
+
+    // the clock of the side to move, before its move.
+    // in_moves_to_go: moves until the next time control, 0 when the game has none
+    void setClock(long long in_remaining_ms, long long in_increment_ms, int in_moves_to_go = 0)
+    {
+        remaining_ms = in_remaining_ms;
+        increment_ms = in_increment_ms;
+        moves_to_go = in_moves_to_go;
+    }
+
+    // the move starts now, critical when the position has threats
+    void startMove(bool critical)
+    {
+        start = std::chrono::steady_clock::now();
+        long long usable = remaining_ms - TIME_MARGIN_MS;
+        if (usable < 1)
+            usable = 1;
+        int moves = moves_to_go > 0 ? moves_to_go : TIME_MOVES_TO_GO;
+        double soft = (double)usable / moves + increment_ms * 0.75;
+        if (critical)
+            soft *= TIME_CRITICAL;
+        double hard = soft * TIME_HARD_RATIO;
+        // never more than a share of the clock, and the last move of a period may use it all
+        double cap = moves == 1 ? usable : usable * TIME_MAX_SHARE + increment_ms * 0.75;
+        if (cap > usable)
+            cap = usable;
+        if (hard > cap)
+            hard = cap;
+        if (soft > hard)
+            soft = hard;
+        soft_ms = soft < 1 ? 1 : (long long)soft;
+        hard_ms = hard < 1 ? 1 : (long long)hard;
+        scale = 1;
+        last_best = Point(-1, -1);
+        stable_iterations = 0;
+        last_iteration_ms = iteration_ms = 0;
+    }
+
+    // milliseconds since startMove
+    long long elapsed() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    long long softBudget() const
+    {
+        long long soft = (long long)(soft_ms * scale);
+        return soft < hard_ms ? soft : hard_ms;
+    }
+
+    long long hardBudget() const
+    {
+        return hard_ms;
+    }
+
+    // after a completed iteration with best move best: false when the search
+    // should stop and play it. forced: best is the only move, decided: the score
+    // is a proven or certain win or loss
+    bool nextIteration(Point best, bool forced, bool decided)
+    {
+        long long now = elapsed();
+        iteration_ms = now - last_iteration_ms;
+        last_iteration_ms = now;
+        if (forced || decided)
+            return false;
+        if (last_best.x != -1 && (best.x != last_best.x || best.y != last_best.y))
+        {
+            scale *= TIME_UNSTABLE;
+            stable_iterations = 0;
+        }
+        else if (last_best.x != -1 && ++stable_iterations > TIME_STABLE_ITERATIONS && scale * TIME_STABLE >= TIME_MIN_SCALE)
+            scale *= TIME_STABLE;
+        last_best = best;
+        if (now >= softBudget())
+            return false;
+        // the next iteration would be cut by the hard budget and thrown away
+        return now + iteration_ms * TIME_BRANCHING < hard_ms;
+    }
+};
+
+#endif // TIME_MANAGER
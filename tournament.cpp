@@ -0,0 +1,526 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <stdlib.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "botbaseline.h"
+#include "custom_bot.h"
+#include "game_record.h"
+#include "rng.h"
+
+using namespace std;
+
+// tournament runner: plays paired openings between two engines on worker processes
+// usage: tournament <engine A> <engine B> [-games N] [-workers N] [-sprt elo0 elo1] [-alpha a] [-beta b] [-record file] [-tc base+inc]
+// engine: baseline | random | gomoku[:depth][+model][+net=file]
+// +model: search the opponent's replies as player_baseline's policy instead of minimax
+// +net=file: evaluate with the network of this weights file (nnue_train.cpp), it comes last
+// -tc base+inc: game clock of base ms per side plus inc ms per move, running out of it loses.
+//     gomoku engines budget their moves with time_manager.h, :depth is then the deepest
+//     iteration (MAX_DEPTH when not given)
+
+const int ENGINE_BASELINE = 0;
+const int ENGINE_RANDOM = 1;
+const int ENGINE_GOMOKU = 2;
+const int OPENING_STONES = 4;   // keep it even so player 1 moves next
+const int OPENING_RADIUS = 3;
+const int MOVE_RETRIES = 5;     // same as play_game
+
+struct EngineSpec{
+    int type;
+    int depth;
+    bool depth_given;
+    bool opponent_model;
+    string net_path;        // weights file of the network evaluation, empty for the pattern scores
+    const Network *network; // loaded from net_path before the workers start
+    string name;
+};
+
+// game clock, base_ms 0 means no clock
+struct TimeControl{
+    long long base_ms;
+    long long increment_ms;
+};
+
+// per side statistics, summed over every move of a game
+struct SideStats{
+    long long moves;
+    long long nodes;
+    long long time_us;
+    long long max_us;
+    long long time_losses;
+};
+
+// result of one game, score_a is 1 / 0 / -1 from engine A's view
+struct GameResult{
+    int pair_id;
+    int score_a;
+    int turns;
+    SideStats stats[2];
+};
+
+struct Worker{
+    pid_t pid;
+    int cmd_fd;
+    int result_fd;
+    int pending;    // games still expected from the current pair
+};
+
+struct SprtState{
+    double elo0, elo1;
+    double alpha, beta;
+    long long wins, draws, losses;
+};
+
+bool parse_engine(const string &text, EngineSpec &spec);
+bool parse_time_control(const string &text, TimeControl &tc);
+bool send_pair(Worker &worker, int pair_id);
+void run_worker(EngineSpec engines[2], const TimeControl &tc, int cmd_fd, int result_fd, const char *record_path);
+GameResult play_pair_game(EngineSpec engines[2], const TimeControl &tc, int pair_id, int first_side, GameRecordWriter *recorder);
+void make_opening(int board[][WIDTH], int pair_id, GameRecordWriter *recorder);
+bool is_win_move(int board[][WIDTH], int x, int y);
+double sprt_llr(const SprtState &s);
+double elo_estimate(const SprtState &s);
+void print_side(const string &label, const EngineSpec &spec, const SideStats &stats);
+
+int main(int argc, char **argv){
+    if(argc < 3){
+        cout<<"usage: tournament <engine A> <engine B> [-games N] [-workers N] [-sprt elo0 elo1] [-alpha a] [-beta b] [-record file] [-tc base+inc]"<<endl;
+        cout<<"engine: baseline | random | gomoku[:depth][+model][+net=file]"<<endl;
+        return 1;
+    }
+
+    EngineSpec engines[2];
+    for(int i = 0; i < 2; i++){
+        if(!parse_engine(argv[i+1], engines[i])){
+            cout<<"unknown engine "<<argv[i+1]<<endl;
+            return 1;
+        }
+    }
+    static Network networks[2];
+    for(int i = 0; i < 2; i++){
+        if(engines[i].net_path.empty()) continue;
+        if(!networks[i].load(engines[i].net_path.c_str())){
+            cout<<"can't load network "<<engines[i].net_path<<endl;
+            return 1;
+        }
+        engines[i].network = &networks[i];
+    }
+
+    int max_games = 1000;
+    const char *record_path = NULL;
+    TimeControl tc = {0, 0};
+    int num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    SprtState sprt;
+    sprt.elo0 = 0;
+    sprt.elo1 = 10;
+    sprt.alpha = 0.05;
+    sprt.beta = 0.05;
+    sprt.wins = sprt.draws = sprt.losses = 0;
+
+    for(int i = 3; i < argc; i++){
+        string arg = argv[i];
+        if(arg == "-games" && i + 1 < argc) max_games = atoi(argv[++i]);
+        else if(arg == "-workers" && i + 1 < argc) num_workers = atoi(argv[++i]);
+        else if(arg == "-alpha" && i + 1 < argc) sprt.alpha = atof(argv[++i]);
+        else if(arg == "-beta" && i + 1 < argc) sprt.beta = atof(argv[++i]);
+        else if(arg == "-record" && i + 1 < argc) record_path = argv[++i];
+        else if(arg == "-tc" && i + 1 < argc){
+            if(!parse_time_control(argv[++i], tc)){
+                cout<<"bad time control "<<argv[i]<<", expected base+inc in ms"<<endl;
+                return 1;
+            }
+        }
+        else if(arg == "-sprt" && i + 2 < argc){
+            sprt.elo0 = atof(argv[++i]);
+            sprt.elo1 = atof(argv[++i]);
+        } else {
+            cout<<"unknown option "<<arg<<endl;
+            return 1;
+        }
+    }
+    if(num_workers < 1) num_workers = 1;
+    int num_pairs = (max_games + 1) / 2;
+    // a write to a dead worker must fail with EPIPE instead of killing the runner
+    signal(SIGPIPE, SIG_IGN);
+    if(num_workers > num_pairs) num_workers = num_pairs;
+
+    // spawn the workers, each one owns a command pipe and a result pipe
+    vector<Worker> workers(num_workers);
+    for(int w = 0; w < num_workers; w++){
+        int cmd_pipe[2], result_pipe[2];
+        if(pipe(cmd_pipe) != 0 || pipe(result_pipe) != 0){
+            perror("pipe");
+            return 1;
+        }
+        pid_t pid = fork();
+        if(pid < 0){
+            perror("fork");
+            return 1;
+        }
+        if(pid == 0){
+            close(cmd_pipe[1]);
+            close(result_pipe[0]);
+            for(int k = 0; k < w; k++){
+                close(workers[k].cmd_fd);
+                close(workers[k].result_fd);
+            }
+            run_worker(engines, tc, cmd_pipe[0], result_pipe[1], record_path);
+            _exit(0);
+        }
+        close(cmd_pipe[0]);
+        close(result_pipe[1]);
+        workers[w].pid = pid;
+        workers[w].cmd_fd = cmd_pipe[1];
+        workers[w].result_fd = result_pipe[0];
+        workers[w].pending = 0;
+    }
+
+    double lower = log(sprt.beta / (1 - sprt.alpha));
+    double upper = log((1 - sprt.beta) / sprt.alpha);
+    SideStats totals[2] = {};
+    int next_pair = 0, running = 0;
+    long long games = 0;
+    string verdict = "inconclusive";
+    bool stop = false, failed = false;
+
+    // work queue: hand out one pair to every idle worker.
+    // A lost pair would bias the result, so a failing worker aborts the run
+    for(int w = 0; w < num_workers && !failed; w++){
+        if(next_pair < num_pairs){
+            if(!send_pair(workers[w], next_pair)){
+                failed = true;
+                break;
+            }
+            next_pair++;
+            running++;
+        }
+    }
+
+    vector<pollfd> fds(num_workers);
+    while(running > 0 && !failed){
+        for(int w = 0; w < num_workers; w++){
+            fds[w].fd = workers[w].pending > 0 ? workers[w].result_fd : -1;
+            fds[w].events = POLLIN;
+            fds[w].revents = 0;
+        }
+        if(poll(fds.data(), fds.size(), -1) < 0){
+            perror("poll");
+            break;
+        }
+        for(int w = 0; w < num_workers; w++){
+            if(fds[w].revents == 0) continue;
+            GameResult result;
+            if(read(workers[w].result_fd, &result, sizeof(result)) != sizeof(result)){
+                cout<<"worker "<<w<<" died"<<endl;
+                failed = true;
+                break;
+            }
+            workers[w].pending--;
+            games++;
+            if(result.score_a > 0) sprt.wins++;
+            else if(result.score_a < 0) sprt.losses++;
+            else sprt.draws++;
+            for(int side = 0; side < 2; side++){
+                totals[side].moves += result.stats[side].moves;
+                totals[side].nodes += result.stats[side].nodes;
+                totals[side].time_us += result.stats[side].time_us;
+                totals[side].max_us = max(totals[side].max_us, result.stats[side].max_us);
+                totals[side].time_losses += result.stats[side].time_losses;
+            }
+
+            double llr = sprt_llr(sprt);
+            cout<<"game "<<games<<" pair "<<result.pair_id<<" score "<<result.score_a<<" turns "<<result.turns
+                <<" | W "<<sprt.wins<<" D "<<sprt.draws<<" L "<<sprt.losses
+                <<" | llr "<<fixed<<setprecision(3)<<llr<<" ["<<lower<<", "<<upper<<"]"<<endl;
+            if(!stop && llr >= upper){
+                verdict = "H1 accepted (" + engines[0].name + " is stronger)";
+                stop = true;
+            } else if(!stop && llr <= lower){
+                verdict = "H0 accepted (" + engines[0].name + " is not stronger)";
+                stop = true;
+            }
+
+            if(workers[w].pending == 0){
+                running--;
+                if(!stop && next_pair < num_pairs){
+                    if(!send_pair(workers[w], next_pair)){
+                        failed = true;
+                        break;
+                    }
+                    next_pair++;
+                    running++;
+                }
+            }
+        }
+        // early stop: don't wait for games that can't change the verdict
+        if(stop) break;
+    }
+
+    if(failed) verdict = "aborted, a worker failed and its pair is missing";
+    for(int w = 0; w < num_workers; w++){
+        int quit = -1;
+        if((stop || failed) && workers[w].pending > 0) kill(workers[w].pid, SIGTERM);
+        else if(write(workers[w].cmd_fd, &quit, sizeof(quit)) != sizeof(quit)) kill(workers[w].pid, SIGTERM);
+        close(workers[w].cmd_fd);
+        close(workers[w].result_fd);
+        waitpid(workers[w].pid, NULL, 0);
+    }
+
+    cout<<"-----------------------------"<<endl;
+    cout<<engines[0].name<<" vs "<<engines[1].name<<": "<<games<<" games, W "<<sprt.wins<<" D "<<sprt.draws<<" L "<<sprt.losses<<endl;
+    cout<<"elo "<<fixed<<setprecision(1)<<elo_estimate(sprt)<<", sprt("<<sprt.elo0<<", "<<sprt.elo1<<"): "<<verdict<<endl;
+    print_side("A", engines[0], totals[0]);
+    print_side("B", engines[1], totals[1]);
+    return failed ? 1 : 0;
+}
+
+bool parse_engine(const string &in_text, EngineSpec &spec){
+    spec.name = in_text;
+    spec.depth = DEPTH;
+    spec.depth_given = false;
+    spec.opponent_model = false;
+    spec.network = NULL;
+    string text = in_text;
+    size_t net = text.find("+net=");
+    if(net != string::npos){
+        spec.net_path = text.substr(net + 5);
+        text = text.substr(0, net);
+        if(spec.net_path.empty() || text.compare(0, 6, "gomoku") != 0) return false;
+    }
+    if(text.size() > 6 && text.compare(text.size() - 6, 6, "+model") == 0){
+        spec.opponent_model = true;
+        text = text.substr(0, text.size() - 6);
+    }
+    if(text == "baseline"){
+        spec.type = ENGINE_BASELINE;
+        return !spec.opponent_model;
+    }
+    if(text == "random"){
+        spec.type = ENGINE_RANDOM;
+        return !spec.opponent_model;
+    }
+    if(text.compare(0, 6, "gomoku") == 0){
+        spec.type = ENGINE_GOMOKU;
+        if(text.size() > 7 && text[6] == ':'){
+            spec.depth = atoi(text.c_str() + 7);
+            spec.depth_given = true;
+        }
+        else if(text.size() != 6) return false;
+        return spec.depth > 0;
+    }
+    return false;
+}
+
+// base+inc, both in milliseconds
+bool parse_time_control(const string &text, TimeControl &tc){
+    size_t plus = text.find('+');
+    if(plus == string::npos || plus == 0 || plus + 1 == text.size()) return false;
+    tc.base_ms = atoll(text.c_str());
+    tc.increment_ms = atoll(text.c_str() + plus + 1);
+    return tc.base_ms > 0 && tc.increment_ms >= 0;
+}
+
+// hand pair_id to an idle worker, false when its command pipe is broken
+bool send_pair(Worker &worker, int pair_id){
+    if(write(worker.cmd_fd, &pair_id, sizeof(pair_id)) != sizeof(pair_id)){
+        perror("write to worker");
+        return false;
+    }
+    worker.pending = 2;
+    return true;
+}
+
+// worker loop: read a pair index, play it with both color assignments, report both games
+void run_worker(EngineSpec engines[2], const TimeControl &tc, int cmd_fd, int result_fd, const char *record_path){
+    GameRecordWriter writer;
+    GameRecordWriter *recorder = NULL;
+    if(record_path != NULL){
+        if(writer.open(record_path)) recorder = &writer;
+        else perror(record_path);
+    }
+    int pair_id;
+    while(read(cmd_fd, &pair_id, sizeof(pair_id)) == sizeof(pair_id) && pair_id >= 0){
+        for(int first_side = 0; first_side < 2; first_side++){
+            GameResult result = play_pair_game(engines, tc, pair_id, first_side, recorder);
+            // the runner is gone, nobody reads the results
+            if(write(result_fd, &result, sizeof(result)) != sizeof(result)) return;
+        }
+    }
+}
+
+// play one game of the pair, first_side is the engine (0 = A, 1 = B) that plays color 1
+GameResult play_pair_game(EngineSpec engines[2], const TimeControl &tc, int pair_id, int first_side, GameRecordWriter *recorder){
+    static int board[HEIGHT][WIDTH];
+    Gomoku bots[2];
+    TimeManager clocks[2];
+    long long clock_us[2] = {tc.base_ms * 1000, tc.base_ms * 1000};
+    GameResult result = {};
+    result.pair_id = pair_id;
+    for(int side = 0; side < 2; side++){
+        bots[side].setDepth(engines[side].depth);
+        if(engines[side].opponent_model) bots[side].setOpponentModel(OPPONENT_BASELINE);
+        if(engines[side].network) bots[side].setNetwork(engines[side].network);
+    }
+
+    if(recorder != NULL) recorder->beginGame(RECORD_HAS_TIME | RECORD_HAS_DEPTH);
+    make_opening(board, pair_id, recorder);
+    Rng rng(pair_id * 2 + first_side + 1);
+
+    int color = 1;
+    for(int turn = OPENING_STONES; turn < HEIGHT * WIDTH; turn++){
+        int side = (color == 1) ? first_side : 1 - first_side;
+        Point position(-1, -1);
+        long long elapsed = 0, move_us = 0;
+        int depth = (engines[side].type == ENGINE_GOMOKU) ? engines[side].depth : 0;
+        bool legal = false;
+        for(int retry = 0; retry < MOVE_RETRIES && !legal; retry++){
+            long long start_nodes = bots[side].getNodeCount();
+            auto start = chrono::steady_clock::now();
+            if(engines[side].type == ENGINE_BASELINE) position = player_baseline(board, color, rng);
+            else if(engines[side].type == ENGINE_RANDOM) position = player_rand(board, color, rng);
+            else if(tc.base_ms > 0){
+                SearchLimits limits;
+                limits.depth = engines[side].depth_given ? engines[side].depth : MAX_DEPTH;
+                limits.clock = &clocks[side];
+                clocks[side].setClock((clock_us[side] - move_us) / 1000, tc.increment_ms);
+                SearchInfo info = bots[side].search(board, color, limits);
+                position = info.best;
+                depth = info.depth;
+            }
+            else position = bots[side].nextMove(board, color);
+            elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+            move_us += elapsed;
+
+            SideStats &stats = result.stats[side];
+            stats.moves++;
+            stats.nodes += bots[side].getNodeCount() - start_nodes;
+            stats.time_us += elapsed;
+            stats.max_us = max(stats.max_us, elapsed);
+
+            legal = position.x >= 0 && position.x < HEIGHT && position.y >= 0 && position.y < WIDTH
+                    && board[position.x][position.y] == 0;
+        }
+        result.turns = turn - OPENING_STONES + 1;
+        if(tc.base_ms > 0){
+            clock_us[side] -= move_us;
+            if(clock_us[side] < 0){
+                // out of time, the move doesn't count
+                result.stats[side].time_losses++;
+                result.score_a = (side == 0) ? -1 : 1;
+                if(recorder != NULL) recorder->endGame(-color);
+                return result;
+            }
+            clock_us[side] += tc.increment_ms * 1000;
+        }
+        if(!legal){
+            // an engine that can't produce a legal move loses the game
+            result.score_a = (side == 0) ? -1 : 1;
+            if(recorder != NULL) recorder->endGame(-color);
+            return result;
+        }
+
+        board[position.x][position.y] = color;
+        if(recorder != NULL) recorder->addMove(position, elapsed, depth);
+        if(is_win_move(board, position.x, position.y)){
+            result.score_a = (side == 0) ? 1 : -1;
+            if(recorder != NULL) recorder->endGame(color);
+            return result;
+        }
+        color = -color;
+    }
+    result.score_a = 0;
+    if(recorder != NULL) recorder->endGame(0);
+    return result;
+}
+
+// both games of a pair start from the same random opening around the center
+void make_opening(int board[][WIDTH], int pair_id, GameRecordWriter *recorder){
+    for(int i = 0; i < HEIGHT; i++){
+        for(int j = 0; j < WIDTH; j++){
+            board[i][j] = 0;
+        }
+    }
+    Rng rng(pair_id * 7919 + 17);
+    int color = 1;
+    int placed = 0;
+    while(placed < OPENING_STONES){
+        int x = HEIGHT / 2 - OPENING_RADIUS + rng.below(2 * OPENING_RADIUS + 1);
+        int y = WIDTH / 2 - OPENING_RADIUS + rng.below(2 * OPENING_RADIUS + 1);
+        if(board[x][y] != 0) continue;
+        board[x][y] = color;
+        if(recorder != NULL) recorder->addMove(Point(x, y));
+        color = -color;
+        placed++;
+    }
+}
+
+// caro rule, same as who_win: five or more in a row that is not blocked at both ends
+bool is_win_move(int board[][WIDTH], int x, int y){
+    int dir_x[] = {1, 0, 1, -1};
+    int dir_y[] = {0, 1, 1, 1};
+    int color = board[x][y];
+    for(int d = 0; d < 4; d++){
+        int count = 1;
+        int open_ends = 0;
+        for(int sign = -1; sign <= 1; sign += 2){
+            int nx = x + sign * dir_x[d], ny = y + sign * dir_y[d];
+            while(nx >= 0 && nx < HEIGHT && ny >= 0 && ny < WIDTH && board[nx][ny] == color){
+                count++;
+                nx += sign * dir_x[d];
+                ny += sign * dir_y[d];
+            }
+            if(nx >= 0 && nx < HEIGHT && ny >= 0 && ny < WIDTH && board[nx][ny] == 0) open_ends++;
+        }
+        if(CaroRule::wins(count, 2 - open_ends)) return true;
+    }
+    return false;
+}
+
+// log-likelihood ratio of elo1 against elo0, normal approximation of the trinomial model.
+// Half a game is added to every outcome so a result that never happened (no
+// losses at all) still gives a positive variance and the test can stop
+double sprt_llr(const SprtState &s){
+    double n = s.wins + s.draws + s.losses;
+    if(n == 0) return 0;
+    double total = n + 1.5;
+    double w = (s.wins + 0.5) / total, d = (s.draws + 0.5) / total;
+    double score = w + d / 2;
+    double var = w + d / 4 - score * score;
+    if(var <= 0) return 0;
+    double s0 = 1 / (1 + pow(10, -s.elo0 / 400));
+    double s1 = 1 / (1 + pow(10, -s.elo1 / 400));
+    return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * var);
+}
+
+double elo_estimate(const SprtState &s){
+    double n = s.wins + s.draws + s.losses;
+    if(n == 0) return 0;
+    double score = (s.wins + s.draws / 2.0) / n;
+    if(score <= 0 || score >= 1) return score <= 0 ? -INFINITY : INFINITY;
+    return -400 * log10(1 / score - 1);
+}
+
+void print_side(const string &label, const EngineSpec &spec, const SideStats &stats){
+    double seconds = stats.time_us / 1e6;
+    cout<<label<<" "<<spec.name<<": "<<stats.moves<<" moves";
+    if(stats.moves > 0){
+        cout<<fixed<<setprecision(3)<<", avg "<<stats.time_us / 1000.0 / stats.moves<<" ms"
+            <<", max "<<stats.max_us / 1000.0<<" ms";
+    }
+    if(seconds > 0 && stats.nodes > 0){
+        cout<<setprecision(0)<<", "<<stats.nodes / seconds<<" nodes/s";
+    }
+    if(stats.time_losses > 0){
+        cout<<", "<<stats.time_losses<<" lost on time";
+    }
+    cout<<endl;
+}
@@ -0,0 +1,76 @@
+#ifndef TRANSPOSITION
+#define TRANSPOSITION
+
+#include <vector>
+#include "config.h"
+
+// bound of a stored score
+const int BOUND_EXACT = 0;
+const int BOUND_LOWER = 1;
+const int BOUND_UPPER = 2;
+
+// depth of results proven by the solver, they are never replaced by heuristic ones
+const int PROVEN_DEPTH = 1000;
+
+struct TTEntry
+{
+    unsigned long long key;
+    double score; // getBoardEvaluation units, white's point of view
+    int move;     // row * WIDTH + col, -1 when unknown
+    short depth;
+    char bound;
+};
+
+// Fixed size hash table indexed by the low bits of the Zobrist key.
+// Memory is only allocated on the first store.
+class TranspositionTable
+{
+private:
+    std::vector<TTEntry> entries;
+    size_t size;
+
+public:
+    // in_size is rounded down to a power of two
+    TranspositionTable(size_t in_size = TT_SIZE)
+    {
+        size = 1;
+        while (size * 2 <= in_size)
+            size *= 2;
+    }
+
+    bool probe(unsigned long long key, TTEntry &entry) const
+    {
+        if (entries.empty())
+            return false;
+        const TTEntry &slot = entries[key & (size - 1)];
+        if (slot.key != key || slot.depth < 0)
+            return false;
+        entry = slot;
+        return true;
+    }
+
+    // keep the deeper result for the same position, proven results stay until cleared
+    void store(unsigned long long key, int depth, int bound, double score, int move)
+    {
+        if (entries.empty())
+        {
+            TTEntry empty = {0, 0, -1, -1, BOUND_EXACT};
+            entries.assign(size, empty);
+        }
+        TTEntry &slot = entries[key & (size - 1)];
+        if (slot.key == key ? depth < slot.depth : slot.depth == PROVEN_DEPTH && depth < PROVEN_DEPTH)
+            return;
+        slot.key = key;
+        slot.score = score;
+        slot.move = move;
+        slot.depth = (short)depth;
+        slot.bound = (char)bound;
+    }
+
+    void clear()
+    {
+        entries.clear();
+    }
+};
+
+#endif // TRANSPOSITION